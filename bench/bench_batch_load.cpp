@@ -0,0 +1,99 @@
+// Compares loading many small disk files with getFiles, which loads them as one batch, against calling getFileFromDisk for each
+// in turn, with the files in the page cache and evicted from it
+
+#include <vfs.hpp>
+
+#include "bench_common.hpp"
+
+#if defined(__unix__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// asks the OS to drop the cached pages of every file, returns false if it can't be done here
+static bool evictFromPageCache(const std::vector<std::string>& paths)
+{
+#if defined(__unix__) && defined(POSIX_FADV_DONTNEED)
+    for(const auto& path : paths)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0)
+        {
+            return false;
+        }
+
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+
+    return true;
+#else
+    (void)paths;
+    return false;
+#endif
+}
+
+// each run uses a new file system so nothing is already loaded, the setup isn't timed
+static double timeLoads(std::size_t runs, bool cold, const std::vector<std::string>& paths, const auto& load)
+{
+    double total = 0.0;
+    for(std::size_t run = 0; run < runs; run++)
+    {
+        if(cold)
+        {
+            evictFromPageCache(paths);
+        }
+
+        vfs::VirtualFS fs;
+        auto start = bench::Clock::now();
+        load(fs);
+        total += std::chrono::duration<double, std::nano>(bench::Clock::now() - start).count();
+    }
+
+    return total / static_cast<double>(runs * paths.size());
+}
+
+int main()
+{
+    constexpr std::size_t FILE_COUNT = 20000;
+    constexpr std::size_t FILE_SIZE = 4 * 1024;
+    constexpr std::size_t RUNS = 3;
+
+    bench::TempDirectory directory{"vfs_bench_batch_load"};
+    std::vector<std::string> paths;
+    for(std::size_t i = 0; i < FILE_COUNT; i++)
+    {
+        paths.push_back(directory.writeFile("file_" + std::to_string(i) + ".bin", FILE_SIZE));
+    }
+
+    std::vector<std::string_view> names(paths.begin(), paths.end());
+
+    auto serialLoad = [&](vfs::VirtualFS& fs) {
+        std::vector<vfs::File> files;
+        for(const auto& path : paths)
+        {
+            files.push_back(fs.getFileFromDisk(path));
+        }
+    };
+
+    auto batchLoad = [&](vfs::VirtualFS& fs) {
+        auto files = fs.getFiles(names);
+        (void)files;
+    };
+
+    std::cout << FILE_COUNT << " files of 4KiB, mean per file" << std::endl;
+    bench::report("warm page cache, getFileFromDisk for each", timeLoads(RUNS, false, paths, serialLoad));
+    bench::report("warm page cache, getFiles", timeLoads(RUNS, false, paths, batchLoad));
+
+    if(evictFromPageCache(paths))
+    {
+        bench::report("cold page cache, getFileFromDisk for each", timeLoads(RUNS, true, paths, serialLoad));
+        bench::report("cold page cache, getFiles", timeLoads(RUNS, true, paths, batchLoad));
+    }
+    else
+    {
+        std::cout << "the page cache can't be dropped here, cold loads are skipped" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Measures bundle lookup throughput with 1 to 64 reader threads while another thread keeps mounting and unmounting a bundle
+
+#include <vfs.hpp>
+
+#include <atomic>
+#include <thread>
+
+#include "bench_common.hpp"
+
+int main()
+{
+    constexpr std::size_t FILE_COUNT = 4096;
+    constexpr std::size_t LOOKUPS_PER_THREAD = 200000;
+
+    std::vector<std::string> fileNames;
+    std::string names;
+    std::vector<vfs::FileIndexEntry> entries;
+    for(std::size_t i = 0; i < FILE_COUNT; i++)
+    {
+        fileNames.push_back("assets/file_" + std::to_string(100000 + i) + ".bin");
+    }
+
+    // names with the same length and prefix sort the same as their numbers
+    for(std::size_t i = 0; i < FILE_COUNT; i++)
+    {
+        entries.push_back(vfs::FileIndexEntry{static_cast<std::uint32_t>(names.size()), static_cast<std::uint32_t>(fileNames[i].size()), i, 1});
+        names += fileNames[i];
+    }
+
+    std::vector<vfs::byte_t> blob(FILE_COUNT, 'x');
+    vfs::Bundle bundle{blob, {}, 1, {names, entries}};
+
+    vfs::VirtualFS fs;
+    fs.addGlobalBundle(bundle);
+    fs.addBundle("mounted", bundle);
+
+    // held so lookups find the loaded resource rather than creating it again
+    std::vector<vfs::File> held;
+    for(const auto& fileName : fileNames)
+    {
+        held.push_back(fs.getFile(fileName));
+        held.push_back(fs.getFileFromMountedBundle("mounted", fileName));
+    }
+
+    std::cout << "lookups per second over " << FILE_COUNT << " files, with a thread mounting and unmounting another bundle" << std::endl;
+
+    for(std::size_t threadCount = 1; threadCount <= 64; threadCount *= 2)
+    {
+        for(bool mounted : {false, true})
+        {
+            std::atomic<bool> stop = false;
+            std::jthread mounter([&]() {
+                while(!stop)
+                {
+                    fs.addBundle("churn", bundle);
+                    fs.removeBundle("churn");
+                }
+            });
+
+            auto start = bench::Clock::now();
+            {
+                std::vector<std::jthread> readers;
+                for(std::size_t t = 0; t < threadCount; t++)
+                {
+                    readers.emplace_back([&, t]() {
+                        std::size_t next = t * 7919;
+                        for(std::size_t i = 0; i < LOOKUPS_PER_THREAD; i++)
+                        {
+                            next = (next + 104729) % FILE_COUNT;
+                            auto file = mounted ? fs.tryGetFileFromMountedBundle("mounted", fileNames[next]) : fs.tryGetFile(fileNames[next]);
+                            (void)file;
+                        }
+                    });
+                }
+            }
+
+            double seconds = std::chrono::duration<double>(bench::Clock::now() - start).count();
+            stop = true;
+
+            std::string name = std::to_string(threadCount) + (mounted ? " threads, mounted bundle" : " threads, global bundle");
+            std::cout << std::left << std::setw(40) << name << std::right << std::setw(16) << std::fixed << std::setprecision(0)
+                << static_cast<double>(threadCount * LOOKUPS_PER_THREAD) / seconds << " /s" << std::endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file bench_common.hpp
+ * @brief Timing helpers shared by the benchmarks
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Runs a function a number of times after a short warm up
+     *
+     * @return double The mean time of one run in nanoseconds
+     */
+    double timePerRun(std::size_t runs, const auto& function)
+    {
+        for(std::size_t i = 0; i < runs / 10 + 1; i++)
+        {
+            function(i);
+        }
+
+        auto start = Clock::now();
+        for(std::size_t i = 0; i < runs; i++)
+        {
+            function(i);
+        }
+
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(runs);
+    }
+
+    inline void report(std::string_view name, double nanoseconds)
+    {
+        std::cout << std::left << std::setw(56) << name << std::right << std::setw(14) << std::fixed << std::setprecision(1) << nanoseconds << " ns" << std::endl;
+    }
+
+    /**
+     * @brief A directory of generated files that is removed again when the benchmark ends
+     */
+    class TempDirectory final
+    {
+    private:
+        std::filesystem::path m_path;
+
+    public:
+        const std::filesystem::path& path() const
+        {
+            return m_path;
+        }
+
+        std::string writeFile(const std::string& name, std::size_t size) const
+        {
+            std::string filePath = (m_path / name).string();
+            std::ofstream file{filePath, std::ios::binary};
+
+            std::vector<char> contents(size);
+            for(std::size_t i = 0; i < size; i++)
+            {
+                contents[i] = static_cast<char>('a' + i % 26);
+            }
+
+            file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+            return filePath;
+        }
+
+        TempDirectory& operator=(const TempDirectory&) = delete;
+        TempDirectory(const TempDirectory&) = delete;
+
+        TempDirectory(std::string_view name) :
+            m_path(std::filesystem::temp_directory_path() / name)
+        {
+            std::filesystem::remove_all(m_path);
+            std::filesystem::create_directories(m_path);
+        }
+
+        ~TempDirectory()
+        {
+            std::error_code removeError;
+            std::filesystem::remove_all(m_path, removeError);
+        }
+    };
+}
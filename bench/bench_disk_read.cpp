@@ -0,0 +1,91 @@
+// Compares loading disk files with the POSIX read path against the std::ifstream path it replaced,
+// on many small files and on a few large ones
+
+#include <vfs.hpp>
+
+#include "bench_common.hpp"
+
+// the previous loader, an ifstream sized with seekg/tellg and a separate call for the modification time
+static std::size_t loadWithStream(const std::string& filePath)
+{
+    std::ifstream fileStream{filePath, std::ios::binary};
+    fileStream.seekg(0, std::ios::end);
+    std::streamoff fileSize = fileStream.tellg();
+    fileStream.seekg(0);
+
+    std::vector<vfs::byte_t> data(static_cast<std::size_t>(fileSize));
+    fileStream.read(reinterpret_cast<char*>(data.data()), fileSize);
+
+    std::error_code timeError;
+    auto modTime = std::filesystem::last_write_time(filePath, timeError);
+    (void)modTime;
+
+    return data.size();
+}
+
+static std::size_t loadWithPosix(const std::string& filePath, const vfs::DiskLoadOptions& loadOptions)
+{
+    auto diskData = vfs::tryLoadDiskData(filePath, loadOptions);
+    return diskData ? diskData->loadedData.size() : 0;
+}
+
+static void compare(std::string_view name, const std::vector<std::string>& paths, std::size_t runs)
+{
+    vfs::DiskLoadOptions loadOptions;
+    vfs::DiskLoadOptions sequentialOptions{vfs::DiskLoadMode::COPY, true, nullptr};
+
+    double streamTime = bench::timePerRun(runs, [&](std::size_t) {
+        for(const auto& path : paths)
+        {
+            loadWithStream(path);
+        }
+    });
+
+    double posixTime = bench::timePerRun(runs, [&](std::size_t) {
+        for(const auto& path : paths)
+        {
+            loadWithPosix(path, loadOptions);
+        }
+    });
+
+    double sequentialTime = bench::timePerRun(runs, [&](std::size_t) {
+        for(const auto& path : paths)
+        {
+            loadWithPosix(path, sequentialOptions);
+        }
+    });
+
+    double fileCount = static_cast<double>(paths.size());
+    std::cout << name << ", mean per file" << std::endl;
+    bench::report("std::ifstream", streamTime / fileCount);
+    bench::report("open, fstat and pread", posixTime / fileCount);
+    bench::report("open, fstat and pread with a sequential hint", sequentialTime / fileCount);
+}
+
+int main()
+{
+    constexpr std::size_t SMALL_FILE_COUNT = 2000;
+    constexpr std::size_t SMALL_FILE_SIZE = 4 * 1024;
+    constexpr std::size_t LARGE_FILE_COUNT = 4;
+    constexpr std::size_t LARGE_FILE_SIZE = 64 * 1024 * 1024;
+
+    bench::TempDirectory directory{"vfs_bench_disk_read"};
+
+    // the warm up runs read every file first, so the timed loads come from the page cache
+    std::vector<std::string> smallPaths;
+    for(std::size_t i = 0; i < SMALL_FILE_COUNT; i++)
+    {
+        smallPaths.push_back(directory.writeFile("small_" + std::to_string(i) + ".bin", SMALL_FILE_SIZE));
+    }
+
+    std::vector<std::string> largePaths;
+    for(std::size_t i = 0; i < LARGE_FILE_COUNT; i++)
+    {
+        largePaths.push_back(directory.writeFile("large_" + std::to_string(i) + ".bin", LARGE_FILE_SIZE));
+    }
+
+    compare(std::to_string(SMALL_FILE_COUNT) + " files of 4KiB", smallPaths, 10);
+    compare(std::to_string(LARGE_FILE_COUNT) + " files of 64MiB", largePaths, 5);
+
+    return 0;
+}
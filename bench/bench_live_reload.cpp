@@ -0,0 +1,68 @@
+// Compares how quickly a change on disk is picked up and how much CPU is used while nothing changes,
+// polling with ASYNC_LIVE_RELOAD against file system events with EVENT_LIVE_RELOAD
+
+#include <vfs.hpp>
+
+#include <ctime>
+#include <thread>
+
+#include "bench_common.hpp"
+
+static void measure(std::string_view modeName, vfs::ReloadMode mode, const bench::TempDirectory& directory, const std::vector<std::string>& paths)
+{
+    constexpr std::size_t CHANGES = 10;
+    constexpr auto IDLE_TIME = std::chrono::seconds(2);
+
+    vfs::VirtualFS fs{mode};
+
+    std::vector<vfs::File> files;
+    for(const auto& path : paths)
+    {
+        files.push_back(fs.getFile(path));
+    }
+
+    // let the watcher settle before measuring
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::clock_t cpuStart = std::clock();
+    std::this_thread::sleep_for(IDLE_TIME);
+    double cpuMilliseconds = 1000.0 * static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+
+    double totalLatency = 0.0;
+    for(std::size_t i = 0; i < CHANGES; i++)
+    {
+        vfs::File& file = files[i * 37 % files.size()];
+        std::uint64_t generation = file.getGeneration();
+
+        auto start = bench::Clock::now();
+        directory.writeFile(std::filesystem::path(paths[i * 37 % paths.size()]).filename().string(), 64 + i);
+        while(file.getGeneration() == generation)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+
+        totalLatency += std::chrono::duration<double, std::milli>(bench::Clock::now() - start).count();
+    }
+
+    std::cout << std::left << std::setw(24) << modeName << std::right << std::fixed << std::setprecision(2)
+        << std::setw(14) << totalLatency / CHANGES << " ms"
+        << std::setw(14) << cpuMilliseconds / std::chrono::duration<double>(IDLE_TIME).count() << " ms/s" << std::endl;
+}
+
+int main()
+{
+    constexpr std::size_t FILE_COUNT = 1000;
+
+    bench::TempDirectory directory{"vfs_bench_live_reload"};
+    std::vector<std::string> paths;
+    for(std::size_t i = 0; i < FILE_COUNT; i++)
+    {
+        paths.push_back(directory.writeFile("file_" + std::to_string(i) + ".txt", 64));
+    }
+
+    std::cout << FILE_COUNT << " tracked files, mean detection latency and CPU time while idle" << std::endl;
+    measure("ASYNC_LIVE_RELOAD", vfs::ReloadMode::ASYNC_LIVE_RELOAD, directory, paths);
+    measure("EVENT_LIVE_RELOAD", vfs::ReloadMode::EVENT_LIVE_RELOAD, directory, paths);
+
+    return 0;
+}
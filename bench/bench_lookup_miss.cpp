@@ -0,0 +1,70 @@
+// Compares the cost of looking up a file that doesn't exist with tryGetFile and with the throwing getFile
+
+#include <vfs.hpp>
+
+#include "bench_common.hpp"
+
+int main()
+{
+    constexpr std::size_t RUNS = 200000;
+    constexpr std::size_t BUNDLE_COUNT = 4;
+
+    static constexpr vfs::byte_t blob[] = {'x'};
+    static constexpr char names[] = "present.txt";
+    static constexpr vfs::FileIndexEntry index[] = {{0, 11, 0, 1}};
+
+    vfs::VirtualFS fs;
+    std::vector<vfs::Bundle> bundles(BUNDLE_COUNT, vfs::Bundle{blob, {}, 1, {std::string_view(names, 11), index}});
+    for(const auto& bundle : bundles)
+    {
+        fs.addGlobalBundle(bundle);
+    }
+
+    std::string missingName = "missing/file.txt";
+
+    double tryTime = bench::timePerRun(RUNS, [&](std::size_t) {
+        auto file = fs.tryGetFile(missingName);
+        (void)file;
+    });
+
+    double throwTime = bench::timePerRun(RUNS, [&](std::size_t) {
+        try
+        {
+            auto file = fs.getFile(missingName);
+            (void)file;
+        }
+        catch(const vfs::FileDoesNotExistError&)
+        {
+        }
+    });
+
+    // the lookup chain used to throw and catch once per global bundle and again in getFile
+    double previousTime = bench::timePerRun(RUNS, [&](std::size_t) {
+        for(std::size_t i = 0; i < BUNDLE_COUNT; i++)
+        {
+            try
+            {
+                throw vfs::FileDoesNotExistError(missingName);
+            }
+            catch(const vfs::FileDoesNotExistError&)
+            {
+            }
+        }
+
+        try
+        {
+            auto file = fs.getFile(missingName);
+            (void)file;
+        }
+        catch(const vfs::FileDoesNotExistError&)
+        {
+        }
+    });
+
+    std::cout << "missing file with " << BUNDLE_COUNT << " global bundles, mean per lookup" << std::endl;
+    bench::report("tryGetFile", tryTime);
+    bench::report("getFile, one throw", throwTime);
+    bench::report("previous chain, one throw per bundle plus getFile", previousTime);
+
+    return 0;
+}
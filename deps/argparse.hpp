@@ -48,6 +48,7 @@ SOFTWARE.
 #include <tuple>
 #include <type_traits>
 #include <variant>
+#include <utility>
 #include <vector>
 
 namespace argparse {
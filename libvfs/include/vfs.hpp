@@ -4,11 +4,53 @@
  */
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <shared_mutex>
+
 #include "vfs_disk.hpp"
 #include "vfs_bundle.hpp"
+#include "vfs_loader.hpp"
+#include "vfs_memory.hpp"
+#include "vfs_pack.hpp"
+#include "vfs_awaitable.hpp"
 
 namespace vfs
 {
+    /**
+     * @brief Called on a loader thread once an asynchronous load has finished
+     * Receives std::nullopt if the file was not found anywhere, must not throw.
+     */
+    using FileLoadCallback = std::function<void(std::optional<File>)>;
+
+    /**
+     * @brief The outcome of resolving one file name with VirtualFS::getFiles
+     */
+    struct FileResult
+    {
+        std::optional<File> file;
+        std::exception_ptr error; // the error getFile would have thrown for this name, null if file is set
+
+        /**
+         * @brief Gets the resolved file
+         * 
+         * @return File The file, rethrows the entry's error if it could not be resolved
+         */
+        File value() const
+        {
+            if(!file)
+            {
+                std::rethrow_exception(error);
+            }
+
+            return *file;
+        }
+    };
+
     /**
      * @brief Allows the access to files from bundles or disk
      * This is the main class that should be used from vfs
@@ -16,9 +58,75 @@ namespace vfs
     class VirtualFS final
     {
     private:
+        /**
+         * @brief A file an interned name resolved to, replaced as a whole so a lookup reads it with one atomic load
+         */
+        struct FileResolution
+        {
+            std::weak_ptr<Resource> resource; // weak so interning a name doesn't keep its file loaded
+            std::uint64_t bundleGeneration;
+        };
+
+        /**
+         * @brief The last resolution of an interned file name
+         */
+        struct FileSlot
+        {
+            std::string name;
+            std::filesystem::path path; // the name as a path, so checking a disk file's freshness doesn't build one
+            std::atomic<std::shared_ptr<const FileResolution>> resolution;
+        };
+
+        static constexpr std::size_t FILE_SLOT_CHUNK_SIZE = 1024;
+        static constexpr std::size_t MAX_FILE_SLOT_CHUNKS = 4096;
+
+        // incremented when a loaded disk file is reloaded or a bundle is added or removed, must be constructed before the disk manager
+        const std::shared_ptr<ChangeCounter> m_changeEpoch;
+
         DiskManager m_diskManager;
         BundleManager m_bundleManager;
 
+        // slots are allocated in chunks that never move, ids are resolved through m_fileSlotChunks without a lock
+        StringMap<FileId> m_fileIds;
+        std::vector<std::unique_ptr<FileSlot[]>> m_fileSlotStorage;
+        std::array<std::atomic<FileSlot*>, MAX_FILE_SLOT_CHUNKS> m_fileSlotChunks{};
+        std::atomic<std::uint32_t> m_fileSlotCount = 0;
+        mutable std::shared_mutex m_fileSlotsLock;
+
+        // bumped whenever the global bundles change so cached FileId resolutions are redone
+        std::atomic<std::uint64_t> m_bundleGeneration = 1;
+
+        /**
+         * @brief An asynchronous load that has been queued but hasn't finished yet
+         */
+        struct PendingLoad
+        {
+            std::shared_future<File> result;
+            std::vector<FileLoadCallback> callbacks;
+
+            // the load is skipped if every requester could cancel and all of them did before it started
+            bool required = false;
+            std::vector<std::stop_token> stopTokens;
+
+            void addRequester(std::stop_token stopToken);
+        };
+
+        std::mutex m_pendingLoadsLock;
+        StringMap<PendingLoad> m_pendingLoads;
+
+        // declared last so the workers are stopped before anything they use is destroyed
+        LoadWorkerPool m_loadWorkers;
+
+        FileSlot& getFileSlot(FileId fileId) const;
+
+        std::shared_ptr<Resource> tryGetResource(std::string_view fileName);
+
+        std::shared_future<File> queueLoad(std::string_view fileName, FileLoadCallback onLoaded, std::stop_token stopToken);
+        void finishAsyncLoad(const std::string& fileName, std::promise<File>& promise);
+        void cancelAsyncLoad(const std::string& fileName, std::promise<File>& promise);
+
+        friend class FileLoadAwaitable;
+
     public:
 
         /**
@@ -40,6 +148,132 @@ namespace vfs
          */
         void pollForUpdatedFiles();
 
+        /**
+         * @brief Sets when cached disk files are checked for changes on lookup
+         * 
+         * @param newPolicy The policy to be used
+         */
+        void setFreshnessPolicy(FreshnessPolicy newPolicy);
+
+        /**
+         * @brief Gets the current Freshness Policy
+         * 
+         * @return FreshnessPolicy The policy currently in use
+         */
+        FreshnessPolicy getFreshnessPolicy() const;
+
+        /**
+         * @brief Sets how long a cached disk file is trusted under FreshnessPolicy::TIME_TO_LIVE
+         * 
+         * @param timeToLive The time after a check during which lookups don't check the file again
+         */
+        void setFreshnessTimeToLive(std::chrono::milliseconds timeToLive);
+
+        /**
+         * @brief Sets how newly loaded disk files hold their contents in memory
+         * 
+         * @param newMode The load mode to be used
+         */
+        void setDiskLoadMode(DiskLoadMode newMode);
+
+        /**
+         * @brief Gets the current Disk Load Mode
+         * 
+         * @return DiskLoadMode The load mode used for newly loaded disk files
+         */
+        DiskLoadMode getDiskLoadMode() const;
+
+        /**
+         * @brief Sets whether newly loaded disk files tell the OS they will be read front to back
+         * 
+         * @param enabled True to advise sequential access when loading
+         */
+        void setSequentialReadHint(bool enabled);
+
+        /**
+         * @brief Gets whether the sequential read hint is used when loading disk files
+         * 
+         * @return bool True if sequential access is advised when loading
+         */
+        bool getSequentialReadHint() const;
+
+        /**
+         * @brief Sets the memory resource that the contents of newly loaded disk files are allocated from
+         * Use a BufferPool to keep constant reloads from fragmenting the heap and to get usage statistics.
+         * Files keep the memory resource they were first loaded with, which is kept alive for as long as they need it.
+         * 
+         * @param memoryResource The memory resource, null to use the default resource
+         */
+        void setMemoryResource(std::shared_ptr<std::pmr::memory_resource> memoryResource);
+
+        /**
+         * @brief Gets the memory resource that the contents of newly loaded disk files are allocated from
+         * 
+         * @return std::shared_ptr<std::pmr::memory_resource> The memory resource, null if the default resource is used
+         */
+        std::shared_ptr<std::pmr::memory_resource> getMemoryResource() const;
+
+        /**
+         * @brief Sets the alignment of the contents of newly loaded disk files
+         * Lets the contents be used directly by SIMD code or aligned I/O, memory mapped files are always aligned to the page size.
+         * 
+         * @param alignment The alignment in bytes, rounded up to a power of two
+         */
+        void setBufferAlignment(std::size_t alignment);
+
+        /**
+         * @brief Gets the alignment of the contents of newly loaded disk files
+         * 
+         * @return std::size_t The alignment in bytes
+         */
+        std::size_t getBufferAlignment() const;
+
+        /**
+         * @brief Sets the most decompressed bytes of compressed bundle files the cache keeps
+         * Compressed files are decompressed when they are first loaded, reloading a file that is still cached doesn't decompress it again.
+         * Every buffer the cache holds is counted, whether or not a file still uses it.
+         * 
+         * @param capacity The capacity in bytes, 0 to not keep any
+         */
+        void setDecompressionCacheSize(std::size_t capacity);
+
+        /**
+         * @brief Gets the usage of the cache of decompressed bundle files
+         * 
+         * @return DecompressionCacheStats The usage
+         */
+        DecompressionCacheStats getDecompressionCacheStats() const;
+
+        /**
+         * @brief Sets whether writes to disk files are queued and written on a background thread
+         * Queued writes are visible to readers straight away, repeated writes to a file before it is flushed are coalesced.
+         * 
+         * @param enabled True to queue writes, false to write them straight away
+         */
+        void setWriteBehind(bool enabled);
+
+        /**
+         * @brief Gets whether writes to disk files are queued
+         * 
+         * @return bool True if writes are queued
+         */
+        bool getWriteBehind() const;
+
+        /**
+         * @brief Writes all queued writes to disk and waits for them to finish
+         * Rethrows the first error that happened while writing in the background since the last flush.
+         */
+        void flushWrites();
+
+        /**
+         * @brief Gets the change epoch of the file system
+         * Incremented whenever a loaded disk file is reloaded or a bundle is added or removed,
+         * if it matches a previously stored value none of the files handed out have changed since.
+         * 
+         * @return std::uint64_t The current epoch
+         */
+        std::uint64_t getChangeEpoch() const;
+
         /**
          * @brief Appends a new global bundle to the list of global bundles
          * 
@@ -60,14 +294,14 @@ namespace vfs
          * @param bundleName The name to access the bundle with 
          * @param bundle The bundle to be added
          */
-        void addBundle(const std::string& bundleName, const Bundle& bundle);
+        void addBundle(std::string_view bundleName, const Bundle& bundle);
         
         /**
          * @brief Removes a named bundle
          * 
          * @param bundleName The name of the budle to be removed
          */
-        void removeBundle(const std::string& bundleName);
+        void removeBundle(std::string_view bundleName);
 
         /**
          * @brief Get a named file from the list of global bundles
@@ -75,7 +309,7 @@ namespace vfs
          * @param fileName The name of the file to be retrieved
          * @return File The file with the given file name
          */
-        File getFileFromGlobalBundle(const std::string& fileName);
+        File getFileFromGlobalBundle(std::string_view fileName);
         
         /**
          * @brief Get a named file from a named bundle
@@ -84,7 +318,7 @@ namespace vfs
          * @param fileName The name of the file to be retrieved
          * @return File The file with the given file name
          */
-        File getFileFromMountedBundle(const std::string& bundleName, const std::string& fileName);
+        File getFileFromMountedBundle(std::string_view bundleName, std::string_view fileName);
 
         /**
          * @brief Get a file from disk
@@ -92,7 +326,16 @@ namespace vfs
          * @param fileName The path to the file on disk
          * @return File The file with the given file name
          */
-        File getFileFromDisk(const std::string& fileName);
+        File getFileFromDisk(std::string_view fileName);
+
+        /**
+         * @brief Get a file from disk, loading it with a specific load mode if it isn't already loaded
+         * 
+         * @param fileName The path to the file on disk
+         * @param loadMode How the contents should be held in memory when the file is loaded
+         * @return File The file with the given file name
+         */
+        File getFileFromDisk(std::string_view fileName, DiskLoadMode loadMode);
 
         /**
          * @brief General file access function
@@ -102,7 +345,138 @@ namespace vfs
          * @param fileName The name of the file to be retrieved
          * @return File The file with the given file name
          */
-        File getFile(const std::string& fileName);
+        File getFile(std::string_view fileName);
+
+        /**
+         * @brief Attempts to get a named file from the list of global bundles without throwing
+         * 
+         * @param fileName The name of the file to be retrieved
+         * @return std::optional<File> The file with the given file name or std::nullopt if it does not exist
+         */
+        std::optional<File> tryGetFileFromGlobalBundle(std::string_view fileName);
+
+        /**
+         * @brief Attempts to get a named file from a named bundle without throwing
+         * 
+         * @param bundleName The name of the bundle in which to search for the file
+         * @param fileName The name of the file to be retrieved
+         * @return std::optional<File> The file with the given file name or std::nullopt if the bundle or file does not exist
+         */
+        std::optional<File> tryGetFileFromMountedBundle(std::string_view bundleName, std::string_view fileName);
+
+        /**
+         * @brief Attempts to get a file from disk without throwing
+         * 
+         * @param fileName The path to the file on disk
+         * @return std::optional<File> The file with the given file name or std::nullopt if it could not be loaded
+         */
+        std::optional<File> tryGetFileFromDisk(std::string_view fileName);
+
+        /**
+         * @brief Attempts to get a file from disk without throwing, loading it with a specific load mode if it isn't already loaded
+         * 
+         * @param fileName The path to the file on disk
+         * @param loadMode How the contents should be held in memory when the file is loaded
+         * @return std::optional<File> The file with the given file name or std::nullopt if it could not be loaded
+         */
+        std::optional<File> tryGetFileFromDisk(std::string_view fileName, DiskLoadMode loadMode);
+
+        /**
+         * @brief Attempts to get many files from disk at once without throwing
+         * Files that aren't loaded yet have their opens and reads submitted together, which is faster than loading them one by one when they aren't cached by the OS.
+         * 
+         * @param fileNames The paths to the files on disk
+         * @return std::vector<std::optional<File>> The files in the same order as fileNames, std::nullopt for files that could not be loaded
+         */
+        std::vector<std::optional<File>> tryGetFilesFromDisk(std::span<const std::string_view> fileNames);
+
+        /**
+         * @brief General file access function that does not throw when a file is missing
+         * Uses the same search order as getFile.
+         * 
+         * @param fileName The name of the file to be retrieved
+         * @return std::optional<File> The file with the given file name or std::nullopt if it was not found anywhere
+         */
+        std::optional<File> tryGetFile(std::string_view fileName);
+
+        /**
+         * @brief General file access function for many files at once that does not throw
+         * Uses the same search order as getFile. Global bundle hits are resolved in one pass, the remaining files are then loaded from disk together.
+         * 
+         * @param fileNames The names of the files to be retrieved
+         * @return std::vector<FileResult> The results in the same order as fileNames, each holding either the file or the error for that name
+         */
+        std::vector<FileResult> getFiles(std::span<const std::string_view> fileNames);
+
+        /**
+         * @brief Interns a file name so it can be looked up by id
+         * Interning the same name twice returns the same id.
+         * 
+         * @param fileName The name of the file
+         * @return FileId The handle for the file name
+         */
+        FileId intern(std::string_view fileName);
+
+        /**
+         * @brief Gets the name that a file id was interned with
+         * 
+         * @param fileId The handle returned from intern
+         * @return std::string_view The interned file name
+         */
+        std::string_view getFileName(FileId fileId) const;
+
+        /**
+         * @brief General file access function using an interned file name
+         * Uses the same search order as getFile but reuses the last resolution while the file is still loaded and no global bundle
+         * has been added or removed, which takes no locks. A disk file is checked against the disk by the freshness policy like getFile does.
+         * 
+         * @param fileId The handle returned from intern
+         * @return File The file with the given id
+         */
+        File getFile(FileId fileId);
+
+        /**
+         * @brief General file access function using an interned file name that does not throw when a file is missing
+         * 
+         * @param fileId The handle returned from intern
+         * @return std::optional<File> The file with the given id or std::nullopt if it was not found anywhere
+         */
+        std::optional<File> tryGetFile(FileId fileId);
+
+        /**
+         * @brief General file access function that loads the file on a loader thread
+         * Uses the same search order as getFile. Requests for a file that is already being loaded share that load.
+         * 
+         * @param fileName The name of the file to be retrieved
+         * @param onLoaded Optional callback run on the loader thread once the load has finished
+         * @return std::shared_future<File> The file with the given file name, holds FileDoesNotExistError if it was not found anywhere
+         */
+        std::shared_future<File> getFileAsync(std::string_view fileName, FileLoadCallback onLoaded = {});
+
+        /**
+         * @brief General file access function for coroutines, co_await the result to get the file
+         * Uses the same search order as getFile and shares loads with getFileAsync. No thread is blocked while the file loads.
+         * 
+         * @param fileName The name of the file to be retrieved
+         * @param stopToken Requesting a stop resumes the coroutine with FileLoadCancelledError, the load is skipped if nobody else needs it
+         * @param scheduler Used to resume the coroutine, resumes on the loader thread if empty
+         * @return FileLoadAwaitable The awaitable that resumes with the file
+         */
+        FileLoadAwaitable loadFile(std::string_view fileName, std::stop_token stopToken = {}, ResumeScheduler scheduler = {});
+
+        /**
+         * @brief Sets the number of threads used for asynchronous loads
+         * 
+         * @param threadCount The number of threads to be used, at least one thread is always used
+         */
+        void setLoadThreadCount(std::size_t threadCount);
+
+        /**
+         * @brief Gets the number of threads used for asynchronous loads
+         * 
+         * @return std::size_t The number of loader threads
+         */
+        std::size_t getLoadThreadCount();
 
         /**
          * @brief Construct a new VirtualFS object
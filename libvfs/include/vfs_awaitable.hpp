@@ -0,0 +1,92 @@
+/**
+ * @file vfs_awaitable.hpp
+ * @brief Contains the awaitable used to load files from coroutines without blocking a thread
+ */
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stop_token>
+#include <string>
+
+#include "vfs_file.hpp"
+
+namespace vfs
+{
+    class VirtualFS;
+
+    /**
+     * @brief Resumes a suspended coroutine, for example by queueing it on a job system
+     * An empty scheduler resumes the coroutine on the thread that finished the load.
+     */
+    using ResumeScheduler = std::function<void(std::coroutine_handle<>)>;
+
+    /**
+     * @brief Awaitable returned by VirtualFS::loadFile
+     * co_await suspends the coroutine until the file has been loaded on a loader thread or the load is cancelled.
+     * The result is a File, FileDoesNotExistError is thrown if it was not found anywhere, FileLoadCancelledError if it was cancelled and any other error the load failed with is rethrown.
+     */
+    class FileLoadAwaitable final
+    {
+    private:
+        /**
+         * @brief State shared with the loader thread and the stop callback, whichever finishes first resumes the coroutine
+         */
+        struct LoadState
+        {
+            std::coroutine_handle<> handle;
+            ResumeScheduler scheduler;
+
+            // the load and the end of await_suspend both have to happen before the coroutine is resumed
+            std::atomic<int> remainingSteps = 2;
+            std::atomic<bool> finished = false;
+
+            std::optional<File> file;
+            bool cancelled = false;
+
+            // holds the exception the load failed with, read once the coroutine is resumed
+            std::shared_future<File> result;
+
+            void finish(std::optional<File> loadedFile, bool wasCancelled);
+            void resume();
+        };
+
+        /**
+         * @brief Finishes the load as cancelled when a stop is requested
+         */
+        struct CancelLoad
+        {
+            std::shared_ptr<LoadState> state;
+
+            void operator()() const;
+        };
+
+        VirtualFS& m_fs;
+        std::string m_fileName;
+        std::stop_token m_stopToken;
+        std::shared_ptr<LoadState> m_state;
+        std::optional<std::stop_callback<CancelLoad>> m_stopCallback;
+
+    public:
+        bool await_ready() const noexcept;
+        bool await_suspend(std::coroutine_handle<> handle);
+        File await_resume();
+
+        /**
+         * @brief Construct a new File Load Awaitable object
+         *
+         * @param fs The file system the file is loaded from
+         * @param fileName The name of the file to be loaded
+         * @param stopToken Token used to cancel the load
+         * @param scheduler Used to resume the coroutine once the load has finished
+         */
+        FileLoadAwaitable(VirtualFS& fs, std::string_view fileName, std::stop_token stopToken, ResumeScheduler scheduler);
+
+        FileLoadAwaitable(const FileLoadAwaitable&) = delete;
+        FileLoadAwaitable& operator=(const FileLoadAwaitable&) = delete;
+    };
+}
@@ -4,8 +4,43 @@
  */
 #pragma once
 #include <cinttypes>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 
 namespace vfs
 {
     using byte_t = std::uint8_t;
-}
\ No newline at end of file
+
+    /**
+     * @brief Handle to an interned file name which can be resolved without hashing the name
+     */
+    struct FileId
+    {
+        std::uint32_t index;
+
+        bool operator==(const FileId&) const = default;
+    };
+
+    /**
+     * @brief Transparent string hash so maps keyed by std::string can be searched with a std::string_view
+     */
+    struct StringHash
+    {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view str) const noexcept
+        {
+            return std::hash<std::string_view>{}(str);
+        }
+    };
+
+    /**
+     * @brief A map keyed by file or bundle names that supports lookups without constructing a std::string
+     * 
+     * @tparam T The mapped type
+     */
+    template<typename T>
+    using StringMap = std::unordered_map<std::string, T, StringHash, std::equal_to<>>;
+}
@@ -4,7 +4,14 @@
  */
 #pragma once
 
+#include <array>
+#include <list>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+
 #include "vfs_bundle_def.hpp"
+#include "vfs_compression.hpp"
 #include "vfs_file.hpp"
 
 namespace vfs
@@ -14,17 +21,70 @@ namespace vfs
      * @brief Handles mounting and access of bundles
      * Allows for the user to store global and named bundles (mounted bundles)
      * Also allows the user to access files within bundles.
+     * All methods are safe to call concurrently, lookups of loaded files only take a shared lock.
      */
     class BundleManager final
     {
     private:
-        std::vector<Bundle> m_globalBundles;
-        std::unordered_map<std::string_view, Bundle> m_mountedBundles;
+        /**
+         * @brief The bundle currently providing a global file along with any resource loaded from it
+         */
+        struct GlobalBundleEntry
+        {
+            const Bundle* bundle;
+            FileTableEntry entry;
+            std::weak_ptr<Resource> resource;
+        };
+
+        /**
+         * @brief One slice of the global index, readers of different files rarely share a shard
+         */
+        struct alignas(64) GlobalIndexShard
+        {
+            mutable std::shared_mutex lock;
+            StringMap<GlobalBundleEntry> entries;
+        };
+
+        /**
+         * @brief A named bundle along with the resources loaded from it
+         */
+        struct MountedBundle
+        {
+            Bundle bundle;
+            StringMap<std::weak_ptr<Resource>> resources;
+        };
+
+        /**
+         * @brief What a bundle resource is made from, copied out under a lock so the resource can be made after it is released
+         */
+        struct BundleFileSource
+        {
+            std::span<const byte_t> blob;
+            std::shared_ptr<const PackFile> pack; // keeps a pack mapped while its file is decompressed
+            FileTableEntry entry;
+
+            bool isSameFile(const Bundle& bundle, const FileTableEntry& fileEntry) const;
+        };
+
+        static constexpr std::size_t GLOBAL_INDEX_SHARD_COUNT = 64;
+        static constexpr std::size_t DEFAULT_DECOMPRESSION_CACHE_SIZE = 32 * 1024 * 1024;
+
+        // ordered from highest to lowest priority, a list keeps bundle pointers stable
+        std::list<Bundle> m_globalBundles;
+        std::mutex m_globalBundlesLock;
+
+        // merged index of every global file with shadowing already resolved
+        std::array<GlobalIndexShard, GLOBAL_INDEX_SHARD_COUNT> m_globalIndexShards;
+
+        StringMap<MountedBundle> m_mountedBundles;
+        mutable std::shared_mutex m_mountedBundlesLock;
 
-        std::unordered_map<std::string, std::pair<const Bundle*, std::weak_ptr<Resource>>> m_globalBundleResources;
-        std::unordered_map<std::string, std::unordered_map<std::string, std::weak_ptr<Resource>>> m_mountedBundleResources;
+        // keeps the contents of recently read compressed files after every file holding them is gone
+        DecompressionCache m_decompressionCache{DEFAULT_DECOMPRESSION_CACHE_SIZE};
 
-        void disownMountedBundle(const std::string& bundleName);
+        GlobalIndexShard& getGlobalIndexShard(std::string_view fileName);
+        std::shared_ptr<Resource> makeBundleResource(const BundleFileSource& source);
+        void disownMountedBundle(MountedBundle& mountedBundle);
 
     public:
 
@@ -48,14 +108,14 @@ namespace vfs
          * @param bundleName The identifier to access the bundle
          * @param bundle The bundle to be attached
          */
-        void addBundle(const std::string& bundleName, const Bundle& bundle);
+        void addBundle(std::string_view bundleName, const Bundle& bundle);
         
         /**
          * @brief Removes a bundle from a given mount point
          * 
          * @param bundleName The bundle to be unmounted
          */
-        void removeBundle(const std::string& bundleName);
+        void removeBundle(std::string_view bundleName);
 
         /**
          * @brief Retrieve a resource from the list of global bundles
@@ -63,7 +123,7 @@ namespace vfs
          * @param fileName The name of the file to be retrieved
          * @return std::shared_ptr<Resource> A pointer to a shared resource representing the bundle data
          */
-        std::shared_ptr<Resource> getResourceFromGlobalBundle(const std::string& fileName);
+        std::shared_ptr<Resource> getResourceFromGlobalBundle(std::string_view fileName);
         
         /**
          * @brief Retrieve a resource from a specified mounted bundle 
@@ -72,7 +132,48 @@ namespace vfs
          * @param fileName The name of the file to be retrieved
          * @return std::shared_ptr<Resource> A pointer to a shared resource representing the bundle data
          */
-        std::shared_ptr<Resource> getResourceFromMountedBundle(const std::string& bundleName, const std::string& fileName);
+        std::shared_ptr<Resource> getResourceFromMountedBundle(std::string_view bundleName, std::string_view fileName);
+
+        /**
+         * @brief Attempts to retrieve a resource from the list of global bundles without throwing
+         * 
+         * @param fileName The name of the file to be retrieved
+         * @return std::shared_ptr<Resource> A pointer to the shared resource or nullptr if no global bundle contains the file
+         */
+        std::shared_ptr<Resource> tryGetResourceFromGlobalBundle(std::string_view fileName);
+
+        /**
+         * @brief Attempts to retrieve many resources from the list of global bundles at once without throwing
+         * Names are grouped by index shard so each shard is only locked once.
+         * 
+         * @param fileNames The names of the files to be retrieved
+         * @return std::vector<std::shared_ptr<Resource>> The resources in the same order as fileNames, nullptr for files no global bundle contains
+         */
+        std::vector<std::shared_ptr<Resource>> tryGetResourcesFromGlobalBundle(std::span<const std::string_view> fileNames);
+
+        /**
+         * @brief Attempts to retrieve a resource from a specified mounted bundle without throwing
+         * 
+         * @param bundleName The name of the bundle to be accessed
+         * @param fileName The name of the file to be retrieved
+         * @return std::shared_ptr<Resource> A pointer to the shared resource or nullptr if the bundle or file does not exist
+         */
+        std::shared_ptr<Resource> tryGetResourceFromMountedBundle(std::string_view bundleName, std::string_view fileName);
+
+        /**
+         * @brief Sets the most decompressed bytes of compressed bundle files the cache keeps
+         * Every buffer the cache holds is counted whether or not a file still uses it. Files that are still in use keep their contents after the cache drops them.
+         * 
+         * @param capacity The capacity in bytes, 0 to decompress files again every time they are loaded
+         */
+        void setDecompressionCacheSize(std::size_t capacity);
+
+        /**
+         * @brief Gets the usage of the cache of decompressed bundle files
+         * 
+         * @return DecompressionCacheStats The usage
+         */
+        DecompressionCacheStats getDecompressionCacheStats() const;
 
         // explicitly disable copying and moving 
         BundleManager& operator=(BundleManager&&) = delete;
@@ -83,4 +184,15 @@ namespace vfs
         BundleManager();
         ~BundleManager();
     };
+
+    /**
+     * @brief Makes a bundle whose files are looked up in a FileIndex built from a list of files, for bundles with very many files made at runtime
+     * The index uses compact entries when every file is uncompressed and ends within 4GiB of the blob start. If a name is given more than once the first is kept.
+     * Throws std::length_error if the names add up to 4GiB or more.
+     * @param blob The data of every file
+     * @param files The name and location of every file within the blob
+     * @param alignment Every file starts at an address that is a multiple of this
+     * @return Bundle The bundle, with an empty file map
+     */
+    Bundle makeIndexedBundle(std::span<const byte_t> blob, std::span<const std::pair<std::string_view, FileTableEntry>> files, std::size_t alignment = 1);
 }
\ No newline at end of file
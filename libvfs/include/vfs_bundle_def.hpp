@@ -3,31 +3,130 @@
  * @brief Contains Bundle structure definition 
  */
 #pragma once
+#include <cstdint>
+#include <memory>
 #include <span>
-#include <unordered_map>
-#include <string>
+#include <string_view>
 
 #include "vfs_base.hpp"
 
 namespace vfs
 {
+    /**
+     * @brief How the contents of a file are stored in a bundle
+     */
+    enum class CompressionMethod : std::uint32_t
+    {
+        NONE = 0, // Stored as they are, read straight from the blob
+        LZ = 1 // Compressed with compressLZ, decompressed when the file is first read
+    };
+
     /**
      * @brief The location of a file within a bundle data blob
      */
     struct FileTableEntry
     {
         std::size_t startByte;
-        std::size_t length;
+        std::size_t length; // The length stored in the blob, which is compressed for compressed files
+        CompressionMethod compression = CompressionMethod::NONE;
+        std::size_t uncompressedSize = 0; // Only used for compressed files
 
         bool operator==(const FileTableEntry&) const = default;
     };
 
+    /**
+     * @brief The name and location of a file in a FileIndex
+     */
+    struct FileIndexEntry
+    {
+        std::uint32_t nameOffset; // From the start of FileIndex::names
+        std::uint32_t nameLength;
+        std::uint64_t startByte;
+        std::uint64_t length;
+        std::uint64_t uncompressedSize = 0; // Only used for compressed files
+        CompressionMethod compression = CompressionMethod::NONE;
+    };
+
+    /**
+     * @brief The name and location of an uncompressed file in a FileIndex whose blob is under 4GiB, 16 bytes with 32-bit offsets and lengths
+     */
+    struct CompactFileIndexEntry
+    {
+        std::uint32_t nameOffset; // From the start of FileIndex::names
+        std::uint32_t nameLength;
+        std::uint32_t startByte;
+        std::uint32_t length;
+    };
+
+    static_assert(sizeof(CompactFileIndexEntry) == 16, "CompactFileIndexEntry must not contain padding");
+
+    /**
+     * @brief A file table sorted by name over one string of every file name, files are found with a binary search
+     * Every part can be constexpr, so bundles generated by vfspack need no dynamic initialization however many files they hold.
+     * Only one of entries and compactEntries is used, compactEntries when every file is uncompressed and ends within 4GiB of the blob start.
+     */
+    struct FileIndex
+    {
+        std::string_view names;
+        std::span<const FileIndexEntry> entries;
+        std::span<const CompactFileIndexEntry> compactEntries = {};
+
+        /**
+         * @brief Gets the name of a file in the index
+         * 
+         * @param entry The file's entry
+         * @return std::string_view The name
+         */
+        constexpr std::string_view getName(const FileIndexEntry& entry) const
+        {
+            return names.substr(entry.nameOffset, entry.nameLength);
+        }
+
+        /**
+         * @brief Gets the name of a file in the index
+         * 
+         * @param entry The file's compact entry
+         * @return std::string_view The name
+         */
+        constexpr std::string_view getName(const CompactFileIndexEntry& entry) const
+        {
+            return names.substr(entry.nameOffset, entry.nameLength);
+        }
+
+        /**
+         * @brief Gets the number of files in the index
+         * 
+         * @return std::size_t The number of files
+         */
+        constexpr std::size_t getFileCount() const
+        {
+            return entries.size() + compactEntries.size();
+        }
+
+        /**
+         * @brief Gets the name of a file by its position in the index
+         * 
+         * @param index The position of the file, less than getFileCount
+         * @return std::string_view The name
+         */
+        constexpr std::string_view getFileName(std::size_t index) const
+        {
+            return compactEntries.empty() ? getName(entries[index]) : getName(compactEntries[index]);
+        }
+    };
+
+    class PackFile;
+
     /**
      * @brief A data blob and file table which contains the file data and file locations within the blob respectfully
      */
     struct Bundle
     {
         std::span<const byte_t> blob;
-        std::unordered_map<std::string, FileTableEntry> files;
+        StringMap<FileTableEntry> files;
+        std::size_t alignment = 1; // Every file starts at an address that is a multiple of this, set by vfspack --alignment
+        FileIndex index = {}; // Set by vfspack and makeIndexedBundle, files are looked up here rather than in files when it has entries
+        std::shared_ptr<const PackFile> pack = nullptr; // Set for bundles opened with openPack, files are then looked up in the pack's index rather than files
+        std::shared_ptr<const void> indexStorage = nullptr; // Owns the names and entries of an index built at runtime by makeIndexedBundle
     };
 }
\ No newline at end of file
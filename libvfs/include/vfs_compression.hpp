@@ -0,0 +1,142 @@
+/**
+ * @file vfs_compression.hpp
+ * @brief Contains the codec used for compressed bundle files and the cache their decompressed contents are kept in
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "vfs_base.hpp"
+#include "vfs_errors.hpp"
+
+namespace vfs
+{
+    /*
+     * compressLZ writes a sequence of blocks, each:
+     *  a token byte, the high four bits are the literal count and the low four bits are the match length minus 4
+     *  if the literal count is 15, bytes that are added to it until one isn't 255
+     *  the literals
+     *  a two byte little endian offset back into the output the match is copied from
+     *  if the match length is 19, bytes that are added to it until one isn't 255
+     * The last block ends after its literals and has no match.
+     */
+
+    /**
+     * @brief Gets the largest size LZ compressed data of a given size can decompress to
+     * Every compressed byte adds at most 255 bytes of output, so a larger uncompressed size can only come from corrupt data.
+     * @param compressedSize The size of the compressed data in bytes
+     * @return std::uint64_t The largest possible decompressed size in bytes
+     */
+    constexpr std::uint64_t getMaxLZDecompressedSize(std::uint64_t compressedSize)
+    {
+        constexpr std::uint64_t MAX_EXPANSION = 255;
+        return compressedSize > std::numeric_limits<std::uint64_t>::max() / MAX_EXPANSION ? std::numeric_limits<std::uint64_t>::max() : compressedSize * MAX_EXPANSION;
+    }
+
+    /**
+     * @brief Compresses data with the LZ codec
+     * The codec favours decompression speed over ratio, a file that doesn't compress comes out slightly larger.
+     * @param data The data to be compressed
+     * @return std::vector<byte_t> The compressed data
+     */
+    std::vector<byte_t> compressLZ(std::span<const byte_t> data);
+
+    /**
+     * @brief Decompresses data written by compressLZ
+     * Throws DecompressionError if the data is corrupt or doesn't decompress to exactly the size of the destination.
+     * @param compressed The compressed data
+     * @param destination Where the data is decompressed to, the size of the original data
+     */
+    void decompressLZ(std::span<const byte_t> compressed, std::span<byte_t> destination);
+
+    /**
+     * @brief Usage of a DecompressionCache
+     */
+    struct DecompressionCacheStats
+    {
+        std::size_t capacity = 0; // The most decompressed bytes the cache keeps
+        std::size_t size = 0; // The decompressed bytes the cache currently keeps
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+    };
+
+    /**
+     * @brief A thread-safe cache of decompressed file contents, bounded by their total size
+     * Contents are keyed by the address of the compressed data and the least recently used are dropped first.
+     * Dropped contents stay alive for as long as a file still holds them.
+     */
+    class DecompressionCache final
+    {
+    private:
+        using Buffer = std::shared_ptr<const std::vector<byte_t>>;
+
+        struct CacheEntry
+        {
+            const byte_t* key;
+            Buffer buffer;
+        };
+
+        // ordered from most to least recently used
+        std::list<CacheEntry> m_entries;
+        std::unordered_map<const byte_t*, std::list<CacheEntry>::iterator> m_index;
+        std::size_t m_capacity;
+        std::size_t m_size = 0;
+        std::size_t m_hits = 0;
+        std::size_t m_misses = 0;
+        std::uint64_t m_evictionGeneration = 0; // bumped by evict, so a decompression that overlapped one isn't cached
+        mutable std::mutex m_lock;
+
+        void trim();
+
+    public:
+        /**
+         * @brief Gets the decompressed contents of a file, decompressing them if they aren't cached
+         * Decompression happens outside the cache lock, so threads asking for different files don't wait on each other.
+         * Contents decompressed while a blob was evicted are returned but not cached, as their address may belong to the evicted blob.
+         * Throws DecompressionError if the data is corrupt.
+         * @param compressed The compressed data, its address identifies the file
+         * @param uncompressedSize The size of the file once decompressed
+         * @return std::shared_ptr<const std::vector<byte_t>> The decompressed contents
+         */
+        std::shared_ptr<const std::vector<byte_t>> getOrDecompress(std::span<const byte_t> compressed, std::size_t uncompressedSize);
+
+        /**
+         * @brief Drops the cached contents of every file whose compressed data lies within a blob
+         * Must be called before the blob is freed, as a new blob at the same address would otherwise be given stale contents.
+         * @param blob The blob
+         */
+        void evict(std::span<const byte_t> blob);
+
+        /**
+         * @brief Sets the most decompressed bytes the cache keeps, dropping contents straight away if it holds more
+         *
+         * @param capacity The capacity in bytes, 0 to not cache anything
+         */
+        void setCapacity(std::size_t capacity);
+
+        /**
+         * @brief Gets the usage of the cache
+         *
+         * @return DecompressionCacheStats The usage
+         */
+        DecompressionCacheStats getStats() const;
+
+        DecompressionCache& operator=(const DecompressionCache&) = delete;
+        DecompressionCache(const DecompressionCache&) = delete;
+
+        /**
+         * @brief Construct a new Decompression Cache object
+         *
+         * @param capacity The most decompressed bytes the cache keeps
+         */
+        DecompressionCache(std::size_t capacity);
+    };
+}
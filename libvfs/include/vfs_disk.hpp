@@ -9,8 +9,14 @@
 #include <variant>
 #include <thread>
 #include <mutex>
+#include <shared_mutex>
+#include <array>
+#include <atomic>
+#include <chrono>
 
 #include "vfs_file.hpp"
+#include "vfs_memory.hpp"
+#include "vfs_writer.hpp"
 
 namespace vfs
 {
@@ -21,7 +27,19 @@ namespace vfs
     {
         NO_LIVE_RELOAD, // No reload callbacks to file observers
         ASYNC_LIVE_RELOAD, // Asynchronous callbacks
-        POLL_LIVE_RELOAD // Polling triggered callbacks which requires the user to call the "pollForUpdatedFiles" method
+        POLL_LIVE_RELOAD, // Polling triggered callbacks which requires the user to call the "pollForUpdatedFiles" method
+        EVENT_LIVE_RELOAD // Asynchronous callbacks driven by file system change events, polls files that can't be watched
+    };
+
+    /**
+     * @brief Represents when a cached disk file is checked against the file on disk before being returned
+     */
+    enum class FreshnessPolicy
+    {
+        ALWAYS_CHECK, // Every lookup checks the modification time of the file on disk
+        TIME_TO_LIVE, // Lookups only check again once the freshness time to live has passed since the last check
+        TRUST_WATCHER, // Lookups never check while ASYNC_LIVE_RELOAD or EVENT_LIVE_RELOAD is enabled, otherwise behaves like ALWAYS_CHECK
+        EXPLICIT_ONLY // Lookups never check, files only change through reload() or live-reloading
     };
 
     /**
@@ -30,18 +48,92 @@ namespace vfs
     class DiskManager final
     {
     private:
-        std::unordered_map<std::string, std::weak_ptr<Resource>> m_diskResources;
+        /**
+         * @brief A tracked disk file, the path is kept so it can be stat'ed without re-allocating
+         */
+        struct DiskResourceEntry
+        {
+            const std::filesystem::path path;
+            std::weak_ptr<Resource> resource;
+
+            // set while EVENT_LIVE_RELOAD has a file system watch covering the file
+            std::atomic<bool> watched = false;
+
+            DiskResourceEntry(const std::string& fileName, std::weak_ptr<Resource> res) : path(fileName), resource(res) {}
+        };
+
+        /**
+         * @brief One slice of the tracked disk files, lookups of different files rarely share a shard
+         */
+        struct alignas(64) DiskResourceShard
+        {
+            mutable std::shared_mutex lock;
+            StringMap<DiskResourceEntry> entries;
+        };
+
+        static constexpr std::size_t DISK_RESOURCE_SHARD_COUNT = 64;
+
+        // shard locks are only held for map access, never across disk I/O
+        std::array<DiskResourceShard, DISK_RESOURCE_SHARD_COUNT> m_diskResourceShards;
+
+        /**
+         * @brief A directory watched for EVENT_LIVE_RELOAD and the tracked files within it
+         */
+        struct WatchedDirectory
+        {
+            // file name within the directory -> names the file is tracked under
+            StringMap<std::vector<std::string>> files;
+        };
+
+        // file system event state, only used by EVENT_LIVE_RELOAD
+        std::mutex m_watchesLock;
+        std::unordered_map<int, WatchedDirectory> m_watchedDirectories;
+        StringMap<int> m_directoryWatches;
+        int m_watchFd = -1;
+        int m_wakeFd = -1;
+        std::atomic<bool> m_hasUnwatchedFiles = false;
 
         std::optional<std::jthread> m_changeCheckThread;
-        std::mutex m_diskResourcesLock;
 
         static constexpr std::int64_t CHANGE_CHECK_DELAY_MS = 100;
 
-        ReloadMode m_reloadMode;
+        std::atomic<ReloadMode> m_reloadMode;
+        std::atomic<FreshnessPolicy> m_freshnessPolicy = FreshnessPolicy::ALWAYS_CHECK;
+        std::atomic<std::chrono::milliseconds::rep> m_freshnessTimeToLiveMs = 0;
+        std::atomic<DiskLoadMode> m_diskLoadMode = DiskLoadMode::COPY;
+        std::atomic<bool> m_sequentialReadHint = false;
+
+        // loads use m_loadMemoryResource, which wraps the chosen resource when buffers have to be aligned
+        mutable std::mutex m_memoryResourceLock;
+        std::shared_ptr<std::pmr::memory_resource> m_memoryResource;
+        std::size_t m_bufferAlignment = 1;
+        std::atomic<std::shared_ptr<std::pmr::memory_resource>> m_loadMemoryResource;
+
+        // shared with every resource loaded by this manager
+        const std::shared_ptr<ChangeCounter> m_changeEpoch;
+        const std::shared_ptr<WriteBehindQueue> m_writeQueue;
 
         void enableAsyncReload();
         void disableAsyncReload();
-        void checkForUpdatedFiles();
+        void enableEventReload();
+        void disableEventReload();
+        void checkForUpdatedFiles(bool unwatchedOnly = false);
+
+        void watchFile(const std::string& fileName, DiskResourceEntry& entry);
+        void waitForWatchEvents(std::int64_t timeoutMs);
+        void wakeReloadThread();
+        void closeWatchDescriptors();
+        void processWatchEvents();
+        void reloadTrackedFile(std::string_view fileName);
+        void unwatchTrackedFile(std::string_view fileName);
+
+        DiskResourceShard& getDiskResourceShard(std::string_view fileName);
+
+        DiskLoadOptions getLoadOptions(DiskLoadMode loadMode) const;
+        void updateLoadMemoryResource();
+        std::shared_ptr<Resource> tryGetCachedDiskResource(std::string_view fileName);
+        // returns the file already cached under the name if another thread loaded it first, otherwise caches and returns file
+        std::shared_ptr<Resource> cacheDiskResource(const std::string& fileName, std::shared_ptr<Resource> file);
 
     public:
         /**
@@ -63,20 +155,186 @@ namespace vfs
          */
         void pollForUpdatedFiles();
 
+        /**
+         * @brief Sets when cached disk files are checked for changes on lookup
+         * 
+         * @param newPolicy The policy to be used
+         */
+        void setFreshnessPolicy(FreshnessPolicy newPolicy);
+
+        /**
+         * @brief Gets the current Freshness Policy
+         * 
+         * @return FreshnessPolicy The policy currently in use
+         */
+        FreshnessPolicy getFreshnessPolicy() const;
+
+        /**
+         * @brief Sets how long a cached disk file is trusted under FreshnessPolicy::TIME_TO_LIVE
+         * 
+         * @param timeToLive The time after a check during which lookups don't check the file again
+         */
+        void setFreshnessTimeToLive(std::chrono::milliseconds timeToLive);
+
         /**
          * @brief Get the Disk Resource object
          * 
          * @param fileName 
          * @return std::shared_ptr<Resource> 
          */
-        std::shared_ptr<Resource> getDiskResource(const std::string& fileName);
+        std::shared_ptr<Resource> getDiskResource(std::string_view fileName);
+
+        /**
+         * @brief Attempts to get the Disk Resource object without throwing
+         * 
+         * @param fileName The path to the file on disk
+         * @return std::shared_ptr<Resource> A pointer to the shared resource or nullptr if the file could not be loaded
+         */
+        std::shared_ptr<Resource> tryGetDiskResource(std::string_view fileName);
+
+        /**
+         * @brief Get the Disk Resource object, loading it with a specific load mode if it isn't already loaded
+         * 
+         * @param fileName The path to the file on disk
+         * @param loadMode How the contents should be held in memory when the file is loaded
+         * @return std::shared_ptr<Resource> A pointer to the shared resource
+         */
+        std::shared_ptr<Resource> getDiskResource(std::string_view fileName, DiskLoadMode loadMode);
+
+        /**
+         * @brief Attempts to get the Disk Resource object without throwing, loading it with a specific load mode if it isn't already loaded
+         * 
+         * @param fileName The path to the file on disk
+         * @param loadMode How the contents should be held in memory when the file is loaded
+         * @return std::shared_ptr<Resource> A pointer to the shared resource or nullptr if the file could not be loaded
+         */
+        std::shared_ptr<Resource> tryGetDiskResource(std::string_view fileName, DiskLoadMode loadMode);
+
+        /**
+         * @brief Attempts to get many Disk Resource objects at once without throwing
+         * Files that aren't loaded yet are loaded together, see tryLoadDiskDataBatch.
+         * 
+         * @param fileNames The paths to the files on disk
+         * @return std::vector<std::shared_ptr<Resource>> The resources in the same order as fileNames, nullptr for files that could not be loaded
+         */
+        std::vector<std::shared_ptr<Resource>> tryGetDiskResources(std::span<const std::string_view> fileNames);
+
+        /**
+         * @brief Attempts to get many Disk Resource objects at once without throwing, loading them with a specific load mode if they aren't already loaded
+         * 
+         * @param fileNames The paths to the files on disk
+         * @param loadMode How the contents should be held in memory when the files are loaded
+         * @return std::vector<std::shared_ptr<Resource>> The resources in the same order as fileNames, nullptr for files that could not be loaded
+         */
+        std::vector<std::shared_ptr<Resource>> tryGetDiskResources(std::span<const std::string_view> fileNames, DiskLoadMode loadMode);
+
+        /**
+         * @brief Sets how newly loaded disk files hold their contents in memory
+         * 
+         * @param newMode The load mode to be used
+         */
+        void setDiskLoadMode(DiskLoadMode newMode);
+
+        /**
+         * @brief Gets the current Disk Load Mode
+         * 
+         * @return DiskLoadMode The load mode used for newly loaded disk files
+         */
+        DiskLoadMode getDiskLoadMode() const;
+
+        /**
+         * @brief Sets whether newly loaded disk files tell the OS they will be read front to back
+         * 
+         * @param enabled True to advise sequential access when loading
+         */
+        void setSequentialReadHint(bool enabled);
+
+        /**
+         * @brief Gets whether the sequential read hint is used when loading disk files
+         * 
+         * @return bool True if sequential access is advised when loading
+         */
+        bool getSequentialReadHint() const;
+
+        /**
+         * @brief Checks whether a loaded disk resource still matches the file on disk
+         * 
+         * @param resource The resource loaded from disk
+         * @param filePath The path the resource was loaded from
+         * @return true The resource is up to date and can be returned as-is
+         * @return false The file on disk is newer, the resource is reloaded in place before it is returned
+         */
+        bool isResourceFresh(const Resource& resource, const std::filesystem::path& filePath) const;
 
         DiskManager& operator=(DiskManager&&) = delete;
         DiskManager& operator=(const DiskManager&) = delete;
         DiskManager(DiskManager&&) = delete;
         DiskManager(const DiskManager&) = delete;
 
-        DiskManager(ReloadMode reloadMode = ReloadMode::NO_LIVE_RELOAD);
+        /**
+         * @brief Sets the memory resource that the contents of newly loaded disk files are allocated from
+         * Files keep the memory resource they were first loaded with, also for reloads and writes.
+         * 
+         * @param memoryResource The memory resource, null to use the default resource
+         */
+        void setMemoryResource(std::shared_ptr<std::pmr::memory_resource> memoryResource);
+
+        /**
+         * @brief Gets the memory resource that the contents of newly loaded disk files are allocated from
+         * 
+         * @return std::shared_ptr<std::pmr::memory_resource> The memory resource, null if the default resource is used
+         */
+        std::shared_ptr<std::pmr::memory_resource> getMemoryResource() const;
+
+        /**
+         * @brief Sets the alignment of the contents of newly loaded disk files
+         * Memory mapped files are always aligned to the page size.
+         * 
+         * @param alignment The alignment in bytes, rounded up to a power of two
+         */
+        void setBufferAlignment(std::size_t alignment);
+
+        /**
+         * @brief Gets the alignment of the contents of newly loaded disk files
+         * 
+         * @return std::size_t The alignment in bytes
+         */
+        std::size_t getBufferAlignment() const;
+
+        /**
+         * @brief Sets whether writes to disk files are queued and written on a background thread
+         * 
+         * @param enabled True to queue writes, false to write them straight away
+         */
+        void setWriteBehind(bool enabled);
+
+        /**
+         * @brief Gets whether writes to disk files are queued
+         * 
+         * @return bool True if writes are queued
+         */
+        bool getWriteBehind() const;
+
+        /**
+         * @brief Writes all queued writes to disk and waits for them to finish
+         * Rethrows the first error that happened while writing in the background since the last flush.
+         */
+        void flushWrites();
+
+        /**
+         * @brief Gets the change epoch of the loaded disk files
+         * 
+         * @return std::uint64_t A value that is incremented every time any loaded disk file is reloaded
+         */
+        std::uint64_t getChangeEpoch() const;
+
+        /**
+         * @brief Construct a new Disk Manager object
+         * 
+         * @param reloadMode The Reload Mode to be used
+         * @param changeEpoch Counter incremented whenever a loaded file is reloaded, a new counter is used if null
+         */
+        DiskManager(ReloadMode reloadMode = ReloadMode::NO_LIVE_RELOAD, std::shared_ptr<ChangeCounter> changeEpoch = nullptr);
         ~DiskManager();
     };
 }
\ No newline at end of file
@@ -5,25 +5,55 @@
 #pragma once
 #include <stdexcept>
 #include <string>
+#include <string_view>
 
 namespace vfs
 {
     class FileDoesNotExistError : public std::runtime_error{
     public:
-        FileDoesNotExistError(const std::string& fileName) : 
-            std::runtime_error("File: \"" + fileName + "\" does not exist!") {}
+        FileDoesNotExistError(std::string_view fileName) : 
+            std::runtime_error("File: \"" + std::string(fileName) + "\" does not exist!") {}
     };
 
     class FileSizeError : public std::runtime_error{
     public:
-        FileSizeError(const std::string& fileName) : 
-            std::runtime_error("File size of \"" + fileName + "\" could not be determined!") {}
+        FileSizeError(std::string_view fileName) : 
+            std::runtime_error("File size of \"" + std::string(fileName) + "\" could not be determined!") {}
+    };
+
+    class FileReadError : public std::runtime_error{
+    public:
+        FileReadError(std::string_view fileName) : 
+            std::runtime_error("File: \"" + std::string(fileName) + "\" could not be read!") {}
+    };
+
+    class FileWriteError : public std::runtime_error{
+    public:
+        FileWriteError(std::string_view fileName) : 
+            std::runtime_error("File: \"" + std::string(fileName) + "\" could not be written!") {}
+    };
+
+    class FileLoadCancelledError : public std::runtime_error{
+    public:
+        FileLoadCancelledError(std::string_view fileName) : 
+            std::runtime_error("Load of file: \"" + std::string(fileName) + "\" was cancelled!") {}
     };
 
     class BundleDoesNotExistError : public std::runtime_error{
     public:
-        BundleDoesNotExistError(const std::string& bundleName) : 
-            std::runtime_error("Bundle: \"" + bundleName + "\" does not exist!") {}
+        BundleDoesNotExistError(std::string_view bundleName) : 
+            std::runtime_error("Bundle: \"" + std::string(bundleName) + "\" does not exist!") {}
+    };
+
+    class PackFormatError : public std::runtime_error{
+    public:
+        PackFormatError(std::string_view fileName) : 
+            std::runtime_error("Pack: \"" + std::string(fileName) + "\" is not a valid pack file!") {}
+    };
+
+    class DecompressionError : public std::runtime_error{
+    public:
+        DecompressionError() : std::runtime_error("Compressed file data is corrupt!") {}
     };
 
     class BundleWriteError : public std::runtime_error{
@@ -6,6 +6,7 @@
 #include <filesystem>
 #include <memory>
 
+#include "vfs_reader.hpp"
 #include "vfs_resource.hpp"
 
 // vfs file search order
@@ -16,14 +17,14 @@ namespace vfs
 {
     /**
      * @brief Provides access to a files data
-     * data() is only valid for the lifetime of the resource access guard object
+     * data() is only valid for the lifetime of the resource access guard object.
+     * The guard holds a snapshot of the contents, reloads while it is held don't change what it sees.
      */
     struct ResourceAccessGuard final
     {
     protected:
-        std::unique_lock<std::mutex> m_dataLock;
-        std::shared_ptr<Resource> m_resource;
-        const std::span<const byte_t> m_data;
+        std::shared_ptr<const ResourceBuffer> m_buffer;
+        std::span<const byte_t> m_data;
 
     public:
 
@@ -42,25 +43,31 @@ namespace vfs
          * 
          * @param contents The temporary access guard to be transferred to this instance
          */
-        ResourceAccessGuard(ResourceAccessGuard&& contents)
+        ResourceAccessGuard(ResourceAccessGuard&& contents) = default;
+
+        /**
+         * @brief Construct a new Resource Access Guard object
+         * 
+         * @param buffer The snapshot of the contents to give access to
+         */
+        ResourceAccessGuard(std::shared_ptr<const ResourceBuffer> buffer) : m_buffer(std::move(buffer))
         {
-            m_dataLock.swap(contents.m_dataLock);
-            std::swap(contents.m_resource, m_resource);
+            if(m_buffer)
+            {
+                m_data = m_buffer->data();
+            }
         }
 
         /**
-         * @brief Construct a new Resource Access Guard object
+         * @brief Construct a new Resource Access Guard object giving access to part of a snapshot
          * 
-         * @param lock A unique_lock that is currently locked so the data can be accessed safely
-         * @param data A reference to the data
-         * @param resource A pointer to the shared resource that owns the data
-         */
-        ResourceAccessGuard(
-            std::unique_lock<std::mutex>& lock,
-            const std::span<const byte_t> data,
-            std::shared_ptr<Resource> resource) : m_resource(resource), m_data(data)
+         * @param buffer The snapshot of the contents that data belongs to
+         * @param data The part of the contents to give access to
+         */
+        ResourceAccessGuard(std::shared_ptr<const ResourceBuffer> buffer, std::span<const byte_t> data) : 
+            m_buffer(std::move(buffer)), 
+            m_data(data)
         {
-            m_dataLock.swap(lock);
         }
     };
 
@@ -83,9 +90,37 @@ namespace vfs
         ResourceAccessGuard read() const;
 
         /**
-         * @brief Currently not implemented
+         * @brief Reads part of the contents of the resource
+         * Contents held in memory are not copied, streamed files only read the requested range from disk.
+         * 
+         * @param offset The offset of the range
+         * @param length The length of the range, clamped to the end of the file
+         * @return ResourceAccessGuard The accessor class to get the data in the range from the resource
+         */
+        ResourceAccessGuard readRange(std::size_t offset, std::size_t length) const;
+
+        /**
+         * @brief Opens a reader that reads the file front to back in chunks
          * 
-         * @param data 
+         * @param chunkSize The maximum size of each chunk in bytes
+         * @param readaheadChunks The number of chunks past the current one to read ahead
+         * @return FileReader The reader, which holds the current snapshot of the contents
+         */
+        FileReader openReader(std::size_t chunkSize = FileReader::DEFAULT_CHUNK_SIZE, std::size_t readaheadChunks = FileReader::DEFAULT_READAHEAD_CHUNKS) const;
+
+        /**
+         * @brief Gets the size of the file's contents without reading them
+         * 
+         * @return std::size_t The size in bytes
+         */
+        std::size_t getSize() const;
+
+        /**
+         * @brief Replaces the contents of a disk file and writes them to disk
+         * The file is replaced atomically, or queued to be written in the background if write-behind is enabled.
+         * Writing doesn't cause the file to be reloaded and doesn't notify observers, the generation is incremented.
+         * 
+         * @param data The new contents
          */
         void write(const std::span<const byte_t> data);
         
@@ -110,6 +145,14 @@ namespace vfs
          */
         bool isDisowned() const;
 
+        /**
+         * @brief Gets the generation of the file's contents
+         * Incremented every time the file is reloaded, a cheap way to poll for changes without an observer.
+         * 
+         * @return std::uint64_t The current generation
+         */
+        std::uint64_t getGeneration() const;
+
         /**
          * @brief Attaches a new observer to watch for reload events
          * 
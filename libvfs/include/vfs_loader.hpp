@@ -0,0 +1,85 @@
+/**
+ * @file vfs_loader.hpp
+ * @brief Contains the worker pool that runs asynchronous file loads off the calling thread
+ */
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vfs
+{
+    /**
+     * @brief A fixed size pool of threads that run queued load jobs in order
+     * Threads are only started once the first job is submitted.
+     */
+    class LoadWorkerPool final
+    {
+    private:
+        /**
+         * @brief A queued job and what is run instead if the pool is destroyed before it starts
+         */
+        struct LoadJob
+        {
+            std::function<void()> run;
+            std::function<void()> cancel;
+        };
+
+        std::mutex m_jobsLock;
+        std::condition_variable_any m_jobsAvailable;
+        std::deque<LoadJob> m_jobs;
+
+        std::vector<std::jthread> m_workers;
+        std::size_t m_threadCount;
+
+        void startWorkers();
+        void stopWorkers();
+        void cancelJobs();
+        void runJobs(std::stop_token stopToken);
+
+    public:
+        /**
+         * @brief Queues a job to be run on one of the worker threads
+         *
+         * @param job The job to be run
+         * @param onCancelled Run instead of the job if the pool is destroyed before the job starts, may be empty
+         */
+        void submit(std::function<void()> job, std::function<void()> onCancelled = {});
+
+        /**
+         * @brief Sets the number of worker threads
+         * Running jobs are finished first, queued jobs are kept and picked up by the new threads.
+         *
+         * @param threadCount The number of threads to be used, at least one thread is always used
+         */
+        void setThreadCount(std::size_t threadCount);
+
+        /**
+         * @brief Gets the number of worker threads
+         *
+         * @return std::size_t The number of threads used once jobs are submitted
+         */
+        std::size_t getThreadCount();
+
+        /**
+         * @brief Construct a new Load Worker Pool object
+         *
+         * @param threadCount The number of threads to be used, at least one thread is always used
+         */
+        LoadWorkerPool(std::size_t threadCount);
+
+        LoadWorkerPool(const LoadWorkerPool&) = delete;
+        LoadWorkerPool& operator=(const LoadWorkerPool&) = delete;
+
+        /**
+         * @brief Destroy the Load Worker Pool object
+         * Jobs that haven't started yet are cancelled, then running jobs are waited for.
+         */
+        ~LoadWorkerPool();
+    };
+}
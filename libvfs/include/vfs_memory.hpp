@@ -0,0 +1,139 @@
+/**
+ * @file vfs_memory.hpp
+ * @brief Contains the pooled memory resource that loaded file contents can be allocated from
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace vfs
+{
+    /**
+     * @brief Usage of one power of two size class of a BufferPool
+     */
+    struct BufferPoolSizeClass
+    {
+        std::size_t blockSize = 0; // The largest buffer in the class, buffers are pooled with others of the same class
+        std::size_t buffersInUse = 0;
+        std::size_t bytesInUse = 0;
+    };
+
+    /**
+     * @brief Usage statistics of a BufferPool, sizes are what was asked for rather than what the pool rounded them up to
+     */
+    struct BufferPoolStats
+    {
+        std::size_t buffersInUse = 0;
+        std::size_t bytesInUse = 0;
+        std::size_t peakBytesInUse = 0;
+        std::size_t totalAllocations = 0;
+
+        std::vector<BufferPoolSizeClass> sizeClasses; // Ordered from the smallest class up
+        std::size_t unpooledBuffersInUse = 0; // Buffers too large to be pooled, which come straight from the upstream resource
+        std::size_t unpooledBytesInUse = 0;
+    };
+
+    /**
+     * @brief A memory resource that raises the alignment of every allocation to a minimum before passing it on
+     */
+    class AlignedMemoryResource final : public std::pmr::memory_resource
+    {
+    private:
+        std::shared_ptr<std::pmr::memory_resource> m_upstream;
+        std::size_t m_alignment;
+
+        std::pmr::memory_resource* getUpstreamResource() const;
+
+    protected:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void* buffer, std::size_t bytes, std::size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    public:
+        /**
+         * @brief Gets the minimum alignment of allocations
+         *
+         * @return std::size_t The alignment in bytes
+         */
+        std::size_t getAlignment() const;
+
+        /**
+         * @brief Gets the memory resource allocations are passed on to
+         *
+         * @return const std::shared_ptr<std::pmr::memory_resource>& The memory resource, null for the default resource
+         */
+        const std::shared_ptr<std::pmr::memory_resource>& getUpstream() const;
+
+        /**
+         * @brief Construct a new Aligned Memory Resource object
+         *
+         * @param alignment The minimum alignment in bytes, rounded up to a power of two
+         * @param upstream Where the memory comes from, the default resource if null
+         */
+        AlignedMemoryResource(std::size_t alignment, std::shared_ptr<std::pmr::memory_resource> upstream = nullptr);
+    };
+
+    /**
+     * @brief A thread-safe memory resource that keeps freed buffers in size classes for reuse
+     * Reloading files over and over reuses the same blocks instead of fragmenting the heap, statistics are grouped by power of two.
+     * Buffers with more than the fundamental alignment are rounded up to a power of two so the pool can align them.
+     * Pooled blocks are only returned to the upstream resource when the pool is destroyed.
+     */
+    class BufferPool final : public std::pmr::memory_resource
+    {
+    private:
+        /**
+         * @brief Counters of one size class
+         */
+        struct SizeClassCounters
+        {
+            std::atomic<std::size_t> buffersInUse = 0;
+            std::atomic<std::size_t> bytesInUse = 0;
+        };
+
+        std::pmr::synchronized_pool_resource m_pool;
+        std::size_t m_largestPooledSize;
+
+        std::unique_ptr<SizeClassCounters[]> m_sizeClasses;
+        std::size_t m_sizeClassCount;
+        SizeClassCounters m_unpooled;
+
+        std::atomic<std::size_t> m_bytesInUse = 0;
+        std::atomic<std::size_t> m_peakBytesInUse = 0;
+        std::atomic<std::size_t> m_totalAllocations = 0;
+
+        SizeClassCounters& getCounters(std::size_t bytes);
+        std::size_t getPooledSize(std::size_t bytes, std::size_t alignment) const;
+
+    protected:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void* buffer, std::size_t bytes, std::size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    public:
+        static constexpr std::size_t SMALLEST_SIZE_CLASS = 64;
+        static constexpr std::size_t DEFAULT_LARGEST_POOLED_SIZE = 1024 * 1024;
+
+        /**
+         * @brief Gets the current usage of the pool
+         *
+         * @return BufferPoolStats The statistics, counters are read one after another so they may be slightly out of step with each other
+         */
+        BufferPoolStats getStats() const;
+
+        BufferPool(const BufferPool&) = delete;
+        BufferPool& operator=(const BufferPool&) = delete;
+
+        /**
+         * @brief Construct a new Buffer Pool object
+         *
+         * @param largestPooledSize Buffers larger than this are allocated from the upstream resource directly, rounded up to a power of two
+         * @param upstream Where the pool gets its memory from
+         */
+        BufferPool(std::size_t largestPooledSize = DEFAULT_LARGEST_POOLED_SIZE, std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+    };
+}
@@ -0,0 +1,118 @@
+/**
+ * @file vfs_pack.hpp
+ * @brief Contains the class that mounts binary pack files written by vfspack at runtime
+ */
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "vfs_bundle_def.hpp"
+#include "vfs_pack_def.hpp"
+#include "vfs_resource.hpp"
+
+namespace vfs
+{
+    /**
+     * @brief A pack file mapped into memory
+     * Only the header is read when the pack is opened, the index and file contents are paged in as they are used
+     * so opening a pack takes the same time whatever its size. Files are looked up with a binary search of the index.
+     */
+    class PackFile final
+    {
+    private:
+        std::variant<MappedData, std::vector<byte_t>> m_storage;
+        std::span<const byte_t> m_contents;
+        PackHeader m_header;
+        std::string m_filePath;
+
+        PackEntry getEntry(std::size_t index) const;
+        std::string_view getEntryName(const PackEntry& entry) const;
+        FileTableEntry getEntryLocation(const PackEntry& entry) const;
+
+    public:
+        /**
+         * @brief Gets the number of files in the pack
+         *
+         * @return std::size_t The number of files
+         */
+        std::size_t getFileCount() const;
+
+        /**
+         * @brief Gets the name of a file by its position in the index
+         * Throws PackFormatError if the entry is corrupt.
+         * @param index The position of the file in the index, less than getFileCount
+         * @return std::string_view The name, valid for the lifetime of the pack
+         */
+        std::string_view getFileName(std::size_t index) const;
+
+        /**
+         * @brief Gets the location of a file in the data region by its position in the index
+         * Throws PackFormatError if the entry is corrupt.
+         * @param index The position of the file in the index, less than getFileCount
+         * @return FileTableEntry The location of the file's contents within getData
+         */
+        FileTableEntry getFileEntry(std::size_t index) const;
+
+        /**
+         * @brief Finds a file by name
+         * Throws PackFormatError if an entry the search passes through is corrupt.
+         * @param fileName The name of the file
+         * @return std::optional<FileTableEntry> The location of the file's contents within getData or std::nullopt if the pack doesn't contain it
+         */
+        std::optional<FileTableEntry> findFile(std::string_view fileName) const;
+
+        /**
+         * @brief Checks every entry of the index
+         * Opening a pack only checks its header, this reads the whole index.
+         * Throws PackFormatError if any entry is corrupt.
+         */
+        void validateIndex() const;
+
+        /**
+         * @brief Gets the data region holding the contents of every file
+         *
+         * @return std::span<const byte_t> The data region, valid for the lifetime of the pack
+         */
+        std::span<const byte_t> getData() const;
+
+        /**
+         * @brief Gets the alignment the files in the data region were written with
+         *
+         * @return std::size_t The alignment in bytes
+         */
+        std::size_t getAlignment() const;
+
+        /**
+         * @brief Gets the path the pack was opened from
+         *
+         * @return const std::string& The path
+         */
+        const std::string& getFilePath() const;
+
+        PackFile& operator=(const PackFile&) = delete;
+        PackFile(const PackFile&) = delete;
+
+        /**
+         * @brief Construct a new Pack File object by mapping a pack into memory
+         * Throws FileDoesNotExistError if the file could not be opened and PackFormatError if it isn't a pack.
+         * Platforms without memory mapping read the whole file instead.
+         * @param filePath The path to the pack file
+         */
+        PackFile(const std::string& filePath);
+    };
+
+    /**
+     * @brief Opens a pack file as a bundle that can be added to a VirtualFS like any other bundle
+     * The bundle keeps the pack mapped for as long as it or any file loaded from it is alive.
+     * Throws FileDoesNotExistError if the file could not be opened and PackFormatError if it isn't a pack.
+     * @param filePath The path to the pack file
+     * @return Bundle The bundle, its files are looked up in the pack's index rather than its file table
+     */
+    Bundle openPack(const std::string& filePath);
+}
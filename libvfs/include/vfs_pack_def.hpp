@@ -0,0 +1,55 @@
+/**
+ * @file vfs_pack_def.hpp
+ * @brief Contains the layout of the binary pack files written by vfspack
+ */
+#pragma once
+#include <array>
+#include <cstdint>
+
+namespace vfs
+{
+    /*
+     * A pack file is laid out as:
+     *  PackHeader
+     *  PackEntry[fileCount], sorted by file name so files can be found with a binary search
+     *  the file names, one after the other without terminators
+     *  the data region, every file in it starts at a multiple of the pack's alignment
+     * Values are stored in the byte order of the machine that wrote the pack, a pack from the other byte order fails the version check.
+     */
+
+    inline constexpr std::array<char, 4> PACK_MAGIC = {'V', 'P', 'A', 'K'};
+    inline constexpr std::uint32_t PACK_VERSION = 2;
+
+    /**
+     * @brief The header at the start of a pack file, offsets are from the start of the file
+     */
+    struct PackHeader
+    {
+        std::array<char, 4> magic;
+        std::uint32_t version;
+        std::uint64_t fileCount;
+        std::uint64_t alignment;
+        std::uint64_t indexOffset;
+        std::uint64_t namesOffset;
+        std::uint64_t namesLength;
+        std::uint64_t dataOffset;
+        std::uint64_t dataLength;
+    };
+
+    /**
+     * @brief The index entry of one file in a pack
+     */
+    struct PackEntry
+    {
+        std::uint32_t nameOffset; // From the start of the file names
+        std::uint32_t nameLength;
+        std::uint64_t startByte; // From the start of the data region
+        std::uint64_t length; // The stored length, which is compressed for compressed files
+        std::uint64_t uncompressedSize; // The same as length for uncompressed files
+        std::uint32_t compression; // A CompressionMethod
+        std::uint32_t reserved; // Written as zero
+    };
+
+    static_assert(sizeof(PackHeader) == 64, "PackHeader must not contain padding");
+    static_assert(sizeof(PackEntry) == 40, "PackEntry must not contain padding");
+}
@@ -0,0 +1,85 @@
+/**
+ * @file vfs_reader.hpp
+ * @brief Contains the reader used to stream a file in chunks
+ */
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "vfs_resource.hpp"
+
+namespace vfs
+{
+    /**
+     * @brief Reads a file front to back in chunks
+     * Streamed disk files are read from disk a chunk at a time while the OS reads the next chunks ahead in the background,
+     * contents already in memory are handed out without copying.
+     * The reader holds the snapshot of the contents it was opened with, reloads don't change what it reads.
+     */
+    class FileReader final
+    {
+    private:
+        std::shared_ptr<const ResourceBuffer> m_buffer;
+        std::size_t m_position = 0;
+        std::size_t m_chunkSize;
+        std::size_t m_readaheadChunks;
+
+        // the end of the range that has already been prefetched
+        std::size_t m_prefetchedTo = 0;
+        std::vector<byte_t> m_chunk;
+
+        void prefetchAhead(std::size_t chunkEnd);
+
+    public:
+        static constexpr std::size_t DEFAULT_CHUNK_SIZE = 256 * 1024;
+        static constexpr std::size_t DEFAULT_READAHEAD_CHUNKS = 2;
+
+        /**
+         * @brief Reads the next chunk of the file
+         *
+         * @return std::span<const byte_t> The chunk, valid until the next call to next or seek, empty at the end of the file
+         */
+        std::span<const byte_t> next();
+
+        /**
+         * @brief Moves the position the next chunk is read from
+         *
+         * @param offset The new position, clamped to the size of the file
+         */
+        void seek(std::size_t offset);
+
+        /**
+         * @brief Gets the position the next chunk is read from
+         *
+         * @return std::size_t The offset in bytes
+         */
+        std::size_t tell() const;
+
+        /**
+         * @brief Gets the size of the file being read
+         *
+         * @return std::size_t The size in bytes
+         */
+        std::size_t size() const;
+
+        /**
+         * @brief Checks whether the whole file has been read
+         *
+         * @return true There is nothing left to read
+         * @return false There are more chunks to read
+         */
+        bool atEnd() const;
+
+        /**
+         * @brief Construct a new File Reader object
+         *
+         * @param buffer The contents to be read
+         * @param chunkSize The maximum size of each chunk in bytes, at least one byte is read at a time
+         * @param readaheadChunks The number of chunks past the current one to read ahead
+         */
+        FileReader(std::shared_ptr<const ResourceBuffer> buffer, std::size_t chunkSize, std::size_t readaheadChunks);
+    };
+}
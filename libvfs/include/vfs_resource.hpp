@@ -3,10 +3,19 @@
  * @brief Contains Resource class definition responsible for storing (or pointing to) data.
  */
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
 #include <span>
 #include <optional>
 #include <filesystem>
+#include <memory>
+#include <memory_resource>
 #include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -20,6 +29,182 @@
 namespace vfs
 {
     using TimePoint = std::filesystem::file_time_type;
+
+    /**
+     * @brief A pmr allocator that leaves elements made without a value uninitialised
+     * Resizing a buffer that is about to be read into doesn't zero it first.
+     * @tparam T The allocated type
+     */
+    template<typename T>
+    class DefaultInitAllocator : public std::pmr::polymorphic_allocator<T>
+    {
+    public:
+        using std::pmr::polymorphic_allocator<T>::polymorphic_allocator;
+
+        template<typename U>
+        struct rebind
+        {
+            using other = DefaultInitAllocator<U>;
+        };
+
+        DefaultInitAllocator() = default;
+
+        template<typename U>
+        DefaultInitAllocator(const DefaultInitAllocator<U>& other) noexcept : 
+            std::pmr::polymorphic_allocator<T>(other.resource())
+        {
+        }
+
+        // copies of a container use the default resource like other pmr containers
+        DefaultInitAllocator select_on_container_copy_construction() const
+        {
+            return DefaultInitAllocator();
+        }
+
+        template<typename U>
+        void construct(U* pointer) noexcept(std::is_nothrow_default_constructible_v<U>)
+        {
+            ::new(static_cast<void*>(pointer)) U;
+        }
+
+        template<typename U, typename... Args>
+        void construct(U* pointer, Args&&... args)
+        {
+            std::pmr::polymorphic_allocator<T>::construct(pointer, std::forward<Args>(args)...);
+        }
+    };
+
+    /**
+     * @brief A buffer of file contents allocated from a memory resource that isn't zeroed when resized
+     */
+    using ByteBuffer = std::vector<byte_t, DefaultInitAllocator<byte_t>>;
+
+    /**
+     * @brief A counter shared by many resources that is incremented whenever any of them changes
+     */
+    using ChangeCounter = std::atomic<std::uint64_t>;
+
+    /**
+     * @brief Represents how the contents of a disk file are held in memory
+     */
+    enum class DiskLoadMode
+    {
+        COPY, // The file is read into a buffer owned by the resource
+        MEMORY_MAP, // The file is mapped read-only into memory, a mapped file must be replaced rather than truncated in place
+        STREAM // The file is kept open and only the ranges that are read are loaded, for files too large to hold in memory
+    };
+
+    /**
+     * @brief Controls how a disk file is loaded and reloaded
+     */
+    struct DiskLoadOptions
+    {
+        DiskLoadMode mode = DiskLoadMode::COPY;
+        bool sequentialHint = false; // Advises the OS that the file will be read front to back so it can read ahead aggressively
+        std::shared_ptr<std::pmr::memory_resource> memoryResource; // Where copied contents are allocated from, the default resource if null
+
+        /**
+         * @brief Gets the memory resource copied contents are allocated from
+         * 
+         * @return std::pmr::memory_resource* The memory resource, never null
+         */
+        std::pmr::memory_resource* getMemoryResource() const
+        {
+            return memoryResource ? memoryResource.get() : std::pmr::get_default_resource();
+        }
+    };
+
+    /**
+     * @brief Owns a read-only memory mapping of a file
+     */
+    class MappedData final
+    {
+    private:
+        void* m_address = nullptr;
+        std::size_t m_length = 0;
+
+    public:
+        /**
+         * @brief Gets the mapped contents of the file
+         * 
+         * @return std::span<const byte_t> A reference to the mapped data
+         */
+        std::span<const byte_t> data() const;
+
+        MappedData& operator=(const MappedData&) = delete;
+        MappedData(const MappedData&) = delete;
+
+        MappedData& operator=(MappedData&& other) noexcept;
+        MappedData(MappedData&& other) noexcept;
+
+        MappedData() = default;
+
+        /**
+         * @brief Takes ownership of an existing mapping
+         * 
+         * @param address The start of the mapping
+         * @param length The length of the mapping in bytes
+         */
+        MappedData(void* address, std::size_t length);
+        ~MappedData();
+    };
+
+    /**
+     * @brief Owns an open file whose contents are read from disk on demand
+     */
+    class StreamedData final
+    {
+    private:
+        int m_fd = -1;
+        std::size_t m_size = 0;
+        std::string m_filePath;
+
+    public:
+        /**
+         * @brief Gets the size of the file when it was opened
+         * 
+         * @return std::size_t The size in bytes
+         */
+        std::size_t size() const
+        {
+            return m_size;
+        }
+
+        /**
+         * @brief Reads part of the file from disk
+         * Throws FileReadError if the read fails.
+         * @param offset The offset in the file to start reading from
+         * @param destination Where the data is read to
+         * @return std::size_t The number of bytes read, less than requested at the end of the file
+         */
+        std::size_t readAt(std::size_t offset, std::span<byte_t> destination) const;
+
+        /**
+         * @brief Asks the OS to start reading part of the file in the background so a later readAt doesn't wait for the disk
+         * 
+         * @param offset The offset of the range
+         * @param length The length of the range in bytes
+         */
+        void prefetch(std::size_t offset, std::size_t length) const;
+
+        StreamedData& operator=(const StreamedData&) = delete;
+        StreamedData(const StreamedData&) = delete;
+
+        StreamedData& operator=(StreamedData&& other) noexcept;
+        StreamedData(StreamedData&& other) noexcept;
+
+        StreamedData() = default;
+
+        /**
+         * @brief Takes ownership of an open file
+         * 
+         * @param fd The file descriptor, or -1 where files are opened for each read
+         * @param size The size of the file in bytes
+         * @param filePath The path of the file
+         */
+        StreamedData(int fd, std::size_t size, std::string filePath);
+        ~StreamedData();
+    };
     
     /**
      * @brief Attempts to return the last time a file was edited on disk
@@ -27,7 +212,15 @@ namespace vfs
      * @param filePath The path to the file
      * @return std::optional<TimePoint> The time the file was edited last
      */
-    std::optional<TimePoint> tryGetLastModTime(const std::string& filePath);
+    std::optional<TimePoint> tryGetLastModTime(const std::filesystem::path& filePath);
+
+    /**
+     * @brief Converts a modification time from stat into a TimePoint without losing precision
+     * The time is converted at the precision of the file clock, so it compares equal with tryGetLastModTime for the same file.
+     * @param modTime The modification time as stored by stat
+     * @return TimePoint The same time on the file clock
+     */
+    TimePoint toTimePoint(const std::timespec& modTime);
 
     /**
      * @brief Helper function to load a file in-full from disk
@@ -37,6 +230,22 @@ namespace vfs
      */
     std::vector<byte_t> loadDataFromDisk(const std::string& filePath);
 
+    /**
+     * @brief Helper function to load a file in-full from disk without throwing
+     * Will return std::nullopt if the file doesn't exist or if its size could not be determined.
+     * @param filePath The path to the file to be read
+     * @return std::optional<std::vector<byte_t>> The data
+     */
+    std::optional<std::vector<byte_t>> tryLoadDataFromDisk(const std::string& filePath);
+
+    /**
+     * @brief Helper function to map a file in-full into memory without throwing
+     * Will return std::nullopt if the file doesn't exist, could not be mapped or memory mapping is unsupported.
+     * @param filePath The path to the file to be mapped
+     * @return std::optional<MappedData> The mapping
+     */
+    std::optional<MappedData> tryMapDataFromDisk(const std::string& filePath);
+
     /**
      * @brief Interface class for an object that wishes to be notified of file reload events
      * @note make persistent?
@@ -54,51 +263,241 @@ namespace vfs
     struct DataReference
     {
         std::span<const byte_t> data;
+        std::shared_ptr<const void> owner; // keeps the data alive, null for data that lives as long as the program
     };
 
     /**
      * @brief Contains data and meta-data loaded from disk
+     * loadedData must be constructed with the memory resource of the load options, moving into it later would copy.
      */
     struct DiskData
     {
         std::string dataSourceFileName;
-        std::vector<byte_t> loadedData;
+        ByteBuffer loadedData;
         std::optional<TimePoint> timeLastModified;
+        DiskLoadOptions loadOptions;
+        MappedData mappedData;
+        StreamedData streamedData;
+    };
+
+    /**
+     * @brief Helper function to load a file and its meta-data from disk without throwing
+     * On POSIX systems the file is opened once and a single fstat provides both its size and modification time.
+     * MEMORY_MAP falls back to COPY on platforms without memory mapping support, STREAM only opens the file.
+     * @param filePath The path to the file to be loaded
+     * @param loadOptions How the file should be loaded
+     * @return std::optional<DiskData> The loaded data or std::nullopt if the file could not be loaded
+     */
+    std::optional<DiskData> tryLoadDiskData(const std::string& filePath, const DiskLoadOptions& loadOptions);
+
+    /**
+     * @brief Helper function to load many files and their meta-data from disk at once without throwing
+     * On Linux the opens and reads of the whole batch are submitted together through io_uring in chunks that fill the ring.
+     * Memory mapped loads and systems without io_uring load the files with tryLoadDiskData on a few threads instead.
+     * @param filePaths The paths to the files to be loaded
+     * @param loadOptions How the files should be loaded
+     * @return std::vector<std::optional<DiskData>> The loaded data in the same order as filePaths, std::nullopt for files that could not be loaded
+     */
+    std::vector<std::optional<DiskData>> tryLoadDiskDataBatch(std::span<const std::string> filePaths, const DiskLoadOptions& loadOptions);
+
+    /**
+     * @brief One immutable version of a resource's contents
+     * A reload publishes a new buffer rather than changing this one, so a reader's view never changes underneath it.
+     */
+    class ResourceBuffer final
+    {
+    private:
+        // declared before the storage so the memory resource outlives the contents allocated from it
+        std::shared_ptr<std::pmr::memory_resource> m_memoryResource;
+        std::variant<DataReference, ByteBuffer, MappedData, StreamedData> m_storage;
+        std::span<const byte_t> m_data;
+        std::optional<TimePoint> m_timeLastModified;
+
+    public:
+        /**
+         * @brief Gets the contents
+         * 
+         * @return std::span<const byte_t> A reference to the data, valid for the lifetime of the buffer
+         */
+        std::span<const byte_t> data() const
+        {
+            return m_data;
+        }
+
+        /**
+         * @brief Gets the size of the contents, including contents that are streamed rather than held in memory
+         * 
+         * @return std::size_t The size in bytes
+         */
+        std::size_t size() const;
+
+        /**
+         * @brief Checks whether the contents are read from disk on demand
+         * 
+         * @return true data() is empty and the contents must be read with readRange
+         * @return false The contents are held in memory
+         */
+        bool isStreamed() const;
+
+        /**
+         * @brief Copies part of the contents, reading it from disk if they are streamed
+         * 
+         * @param offset The offset to start copying from
+         * @param destination Where the data is copied to
+         * @return std::size_t The number of bytes copied, less than requested at the end of the contents
+         */
+        std::size_t readRange(std::size_t offset, std::span<byte_t> destination) const;
+
+        /**
+         * @brief Hints that part of the contents will be read soon, only has an effect on streamed contents
+         * 
+         * @param offset The offset of the range
+         * @param length The length of the range in bytes
+         */
+        void prefetch(std::size_t offset, std::size_t length) const;
+
+        /**
+         * @brief Gets the modification time of the file these contents were loaded from
+         * 
+         * @return std::optional<TimePoint> The time or std::nullopt if the contents aren't from disk
+         */
+        std::optional<TimePoint> getLastModifiedTime() const
+        {
+            return m_timeLastModified;
+        }
+
+        ResourceBuffer& operator=(const ResourceBuffer&) = delete;
+        ResourceBuffer(const ResourceBuffer&) = delete;
+
+        /**
+         * @brief Construct a new Resource Buffer object referencing data in memory
+         * 
+         * @param reference The data, which must outlive the buffer unless it has an owner
+         */
+        ResourceBuffer(DataReference reference);
+
+        /**
+         * @brief Construct a new Resource Buffer object taking the contents loaded from disk
+         * 
+         * @param diskData The loaded data and its meta-data
+         */
+        ResourceBuffer(DiskData&& diskData);
+
+        /**
+         * @brief Gets the memory resource the contents were allocated from
+         * 
+         * @return const std::shared_ptr<std::pmr::memory_resource>& The memory resource, null for the default resource
+         */
+        const std::shared_ptr<std::pmr::memory_resource>& getMemoryResource() const
+        {
+            return m_memoryResource;
+        }
+
+        /**
+         * @brief Construct a new Resource Buffer object taking ownership of some data
+         * 
+         * @param data The data
+         * @param timeLastModified The modification time of the file the data came from, if any
+         * @param memoryResource The memory resource data was allocated from, kept alive by the buffer
+         */
+        ResourceBuffer(ByteBuffer&& data, std::optional<TimePoint> timeLastModified, std::shared_ptr<std::pmr::memory_resource> memoryResource);
+
+        /**
+         * @brief Construct a new Resource Buffer object sharing the in memory contents of another with a different modification time
+         * 
+         * @param contents The buffer whose contents are shared, kept alive by the new buffer
+         * @param timeLastModified The modification time of the new buffer
+         */
+        ResourceBuffer(std::shared_ptr<const ResourceBuffer> contents, std::optional<TimePoint> timeLastModified);
+    };
+
+    /**
+     * @brief Helper function to replace a file's contents so readers never see a partially written file
+     * The data is written to a temporary file in the same directory which is then renamed over the file.
+     * Throws FileWriteError if the file could not be written.
+     * @param filePath The path to the file to be written
+     * @param data The new contents of the file
+     * @return std::optional<TimePoint> The modification time of the written file
+     */
+    std::optional<TimePoint> writeDataToDisk(const std::string& filePath, std::span<const byte_t> data);
+
+    class WriteBehindQueue;
+
+    /**
+     * @brief Where a disk resource is loaded from
+     */
+    struct DiskSource
+    {
+        std::string fileName;
+        DiskLoadOptions loadOptions;
     };
 
     /**
      * @brief Represents a source of data from either ownership of the data or a reference to some data in memory
+     * Reads take a snapshot of the current buffer without locking, reloads and writes swap in a new buffer without waiting for readers.
      */
-    class Resource final
+    class Resource final : public std::enable_shared_from_this<Resource>
     {
     private:
-        std::variant<DataReference, DiskData> m_data;
+        const std::optional<DiskSource> m_diskSource;
+        std::atomic<std::shared_ptr<const ResourceBuffer>> m_buffer;
         std::vector<std::shared_ptr<ResourceChangeObserver>> m_observers;
-        mutable std::mutex m_dataLock;
+        std::mutex m_reloadLock;
         mutable std::mutex m_observersLock;
 
-        bool m_disowned = false;
+        std::atomic<bool> m_disowned = false;
+
+        // incremented after every new buffer is published, the epoch is shared with the owner of the resource
+        std::atomic<std::uint64_t> m_generation = 0;
+        const std::shared_ptr<ChangeCounter> m_changeEpoch;
+
+        // set while the contents have been written in memory but not yet to disk
+        const std::shared_ptr<WriteBehindQueue> m_writeQueue;
+        std::atomic<bool> m_writePending = false;
+
+        void replaceFromDisk();
+        void publishWrite(std::span<const byte_t> data, std::optional<TimePoint> timeLastModified);
+        void flushWrite();
+        void notifyObservers();
+
+        friend class WriteBehindQueue;
+
+        // when the data was last known to match the file on disk, stored as steady clock ticks
+        mutable std::atomic<std::chrono::steady_clock::rep> m_lastCheckedTicks;
 
     public:
 
         /**
          * @brief Gives the caller access to read the resource
          * 
-         * @return std::pair<std::unique_lock<std::mutex>, const std::span<const byte_t>> Returns a reference to some data and a lock to use while accessing the data
+         * @return std::shared_ptr<const ResourceBuffer> The current contents, which stay valid and unchanged for as long as the caller holds them
          */
-        std::pair<std::unique_lock<std::mutex>, const std::span<const byte_t>> read() const;
+        std::shared_ptr<const ResourceBuffer> read() const;
 
         /**
-         * @brief Writes the file back to disk (Not implemented)
+         * @brief Replaces the contents of the file and writes them to disk
+         * The file on disk is replaced atomically. With write-behind enabled only the contents in memory are replaced straight away
+         * and the write to disk is queued, repeated writes before it is flushed only write the latest contents.
+         * Writes are not picked up as changes on disk, so they never cause a reload.
          * 
-         * @param data 
+         * @param data The new contents
          */
         void write(const std::span<const byte_t> data);
         
         /**
          * @brief Re-reads the file from disk
+         * Readers keep the contents they already hold, later reads see the new contents.
+         * Does nothing while a queued write hasn't been flushed, as the contents in memory are newer than the file.
          */
         void reload();
+
+        /**
+         * @brief Re-reads the file from disk if it was modified since it was loaded or written
+         * 
+         * @return true The file was reloaded
+         * @return false The file is unchanged, missing or has a queued write
+         */
+        bool reloadIfModified();
         
         /**
          * @brief Disowns the resource meaning it is now invalid and cannot be read / written 
@@ -112,6 +511,28 @@ namespace vfs
          */
         std::optional<TimePoint> getLastModifiedTime() const;
 
+        /**
+         * @brief Gets the generation of the resource's contents
+         * Starts at zero and is incremented every time the contents are reloaded, compare it against a stored value to find out whether anything changed.
+         * 
+         * @return std::uint64_t The current generation
+         */
+        std::uint64_t getGeneration() const;
+
+        /**
+         * @brief Gets the time the resource was last loaded or confirmed to match the file on disk
+         * 
+         * @return std::chrono::steady_clock::time_point The time of the last check
+         */
+        std::chrono::steady_clock::time_point getLastCheckedTime() const;
+
+        /**
+         * @brief Records that the resource was confirmed to match the file on disk
+         * 
+         * @param checkTime The time of the check
+         */
+        void setLastCheckedTime(std::chrono::steady_clock::time_point checkTime) const;
+
         /**
          * @brief Checks whether the resource has been disowned 
          * 
@@ -160,8 +581,9 @@ namespace vfs
          * @brief Construct a new Resource object from a reference to some data in memory
          * 
          * @param data Pointer to data in memory
+         * @param owner Kept alive for as long as the data is referenced, null if the data outlives the resource anyway
          */
-        Resource(const std::span<const byte_t> data);
+        Resource(const std::span<const byte_t> data, std::shared_ptr<const void> owner = nullptr);
 
         /**
          * @brief Construct a new Resource object from loading a file from disk
@@ -169,5 +591,14 @@ namespace vfs
          * @param fileName The name of the file to be read
          */
         Resource(const std::string& fileName);
+
+        /**
+         * @brief Construct a new Resource object from data that has already been loaded from disk
+         * 
+         * @param diskData The loaded data and its meta-data
+         * @param changeEpoch Counter incremented along with the resource's generation, may be null
+         * @param writeQueue Queue used for writes while write-behind is enabled, may be null
+         */
+        Resource(DiskData&& diskData, std::shared_ptr<ChangeCounter> changeEpoch = nullptr, std::shared_ptr<WriteBehindQueue> writeQueue = nullptr);
     };
 }
\ No newline at end of file
@@ -0,0 +1,95 @@
+/**
+ * @file vfs_writer.hpp
+ * @brief Contains the queue that writes disk files in the background
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "vfs_resource.hpp"
+
+namespace vfs
+{
+    /**
+     * @brief Writes the contents of disk resources to disk on a background thread
+     * A resource is queued once per flush however often it is written, the latest contents are written when it is flushed.
+     * The thread is only started once the first write is queued.
+     */
+    class WriteBehindQueue final
+    {
+    private:
+        std::mutex m_queueLock;
+        std::condition_variable_any m_writesQueued;
+        std::condition_variable m_writesFlushed;
+        std::vector<std::shared_ptr<Resource>> m_queued;
+        std::size_t m_flushing = 0;
+
+        // the first error since the last flush, reported by flush
+        std::exception_ptr m_writeError;
+
+        std::atomic<bool> m_enabled = false;
+        std::optional<std::jthread> m_writeThread;
+
+        // gives repeated writes to the same files time to be coalesced before they are flushed
+        static constexpr std::int64_t WRITE_DELAY_MS = 50;
+
+        void writeQueued(std::vector<std::shared_ptr<Resource>>& resources);
+        void runWrites(std::stop_token stopToken);
+
+    public:
+        /**
+         * @brief Queues a resource whose contents have to be written to disk
+         *
+         * @param resource The resource to be written
+         */
+        void queue(std::shared_ptr<Resource> resource);
+
+        /**
+         * @brief Writes everything that is queued and waits for writes already in progress
+         * Rethrows the first error that happened while writing since the last flush.
+         */
+        void flush();
+
+        /**
+         * @brief Sets whether writes to disk resources are queued
+         * Disabling it doesn't drop writes that are already queued.
+         *
+         * @param enabled True to queue writes, false to write them straight away
+         */
+        void setEnabled(bool enabled);
+
+        /**
+         * @brief Checks whether writes to disk resources are queued
+         *
+         * @return true Writes are queued and written in the background
+         * @return false Writes are written straight away
+         */
+        bool isEnabled() const;
+
+        /**
+         * @brief Disables the queue, stops the background thread and writes everything that is still queued
+         * Errors are ignored as there is nobody left to report them to.
+         */
+        void stop();
+
+        WriteBehindQueue() = default;
+
+        WriteBehindQueue(const WriteBehindQueue&) = delete;
+        WriteBehindQueue& operator=(const WriteBehindQueue&) = delete;
+
+        /**
+         * @brief Destroy the Write Behind Queue object
+         * Stops the queue first, see stop.
+         */
+        ~WriteBehindQueue();
+    };
+}
@@ -4,25 +4,414 @@
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <algorithm>
 
 namespace vfs
 {
-    File VirtualFS::getFileFromDisk(const std::string& fileName)
+    static std::size_t defaultLoadThreadCount()
+    {
+        // loads are mostly waiting on the disk, a few threads are enough to keep it busy
+        return std::clamp<std::size_t>(std::thread::hardware_concurrency(), 1, 4);
+    }
+
+    static std::optional<File> toOptionalFile(std::shared_ptr<Resource> res)
+    {
+        if(!res)
+        {
+            return std::nullopt;
+        }
+
+        return File(res);
+    }
+
+    File VirtualFS::getFileFromDisk(std::string_view fileName)
     {
         return File(m_diskManager.getDiskResource(fileName));
     }
 
-    File VirtualFS::getFile(const std::string& fileName)
+    File VirtualFS::getFileFromDisk(std::string_view fileName, DiskLoadMode loadMode)
+    {
+        return File(m_diskManager.getDiskResource(fileName, loadMode));
+    }
+
+    File VirtualFS::getFile(std::string_view fileName)
+    {
+        auto file = tryGetFile(fileName);
+        if(!file)
+        {
+            throw FileDoesNotExistError(fileName);
+        }
+
+        return *file;
+    }
+
+    std::optional<File> VirtualFS::tryGetFileFromGlobalBundle(std::string_view fileName)
+    {
+        return toOptionalFile(m_bundleManager.tryGetResourceFromGlobalBundle(fileName));
+    }
+
+    std::optional<File> VirtualFS::tryGetFileFromMountedBundle(std::string_view bundleName, std::string_view fileName)
     {
+        return toOptionalFile(m_bundleManager.tryGetResourceFromMountedBundle(bundleName, fileName));
+    }
+
+    std::optional<File> VirtualFS::tryGetFileFromDisk(std::string_view fileName)
+    {
+        return toOptionalFile(m_diskManager.tryGetDiskResource(fileName));
+    }
+
+    std::optional<File> VirtualFS::tryGetFileFromDisk(std::string_view fileName, DiskLoadMode loadMode)
+    {
+        return toOptionalFile(m_diskManager.tryGetDiskResource(fileName, loadMode));
+    }
+
+    std::vector<std::optional<File>> VirtualFS::tryGetFilesFromDisk(std::span<const std::string_view> fileNames)
+    {
+        auto resources = m_diskManager.tryGetDiskResources(fileNames);
+
+        std::vector<std::optional<File>> files;
+        files.reserve(resources.size());
+        for(auto& res : resources)
+        {
+            files.push_back(toOptionalFile(std::move(res)));
+        }
+
+        return files;
+    }
+
+    std::shared_ptr<Resource> VirtualFS::tryGetResource(std::string_view fileName)
+    {
+        auto res = m_bundleManager.tryGetResourceFromGlobalBundle(fileName);
+        if(!res)
+        {
+            res = m_diskManager.tryGetDiskResource(fileName);
+        }
+
+        return res;
+    }
+
+    std::optional<File> VirtualFS::tryGetFile(std::string_view fileName)
+    {
+        return toOptionalFile(tryGetResource(fileName));
+    }
+
+    std::vector<FileResult> VirtualFS::getFiles(std::span<const std::string_view> fileNames)
+    {
+        std::vector<FileResult> results(fileNames.size());
+
         try
         {
-            return getFileFromGlobalBundle(fileName);
+            auto resources = m_bundleManager.tryGetResourcesFromGlobalBundle(fileNames);
+
+            // everything the bundles don't have is looked for on disk
+            std::vector<std::string_view> diskNames;
+            std::vector<std::size_t> diskIndices;
+            for(std::size_t i = 0; i < resources.size(); i++)
+            {
+                if(!resources[i])
+                {
+                    diskNames.push_back(fileNames[i]);
+                    diskIndices.push_back(i);
+                }
+            }
+
+            auto diskResources = m_diskManager.tryGetDiskResources(diskNames);
+            for(std::size_t i = 0; i < diskResources.size(); i++)
+            {
+                resources[diskIndices[i]] = std::move(diskResources[i]);
+            }
+
+            for(std::size_t i = 0; i < resources.size(); i++)
+            {
+                if(resources[i])
+                {
+                    results[i].file = File(std::move(resources[i]));
+                }
+                else
+                {
+                    results[i].error = std::make_exception_ptr(FileDoesNotExistError(fileNames[i]));
+                }
+            }
+        }
+        catch(...)
+        {
+            // a failure part way leaves every name that wasn't resolved yet with that failure
+            auto error = std::current_exception();
+            for(auto& result : results)
+            {
+                if(!result.file && !result.error)
+                {
+                    result.error = error;
+                }
+            }
+        }
+
+        return results;
+    }
+
+    FileId VirtualFS::intern(std::string_view fileName)
+    {
+        {
+            std::shared_lock<std::shared_mutex> lock{m_fileSlotsLock};
+
+            auto idItr = m_fileIds.find(fileName);
+            if(idItr != m_fileIds.end())
+            {
+                return idItr->second;
+            }
+        }
+
+        std::unique_lock<std::shared_mutex> lock{m_fileSlotsLock};
+
+        auto idItr = m_fileIds.find(fileName);
+        if(idItr != m_fileIds.end())
+        {
+            return idItr->second;
+        }
+
+        std::uint32_t index = m_fileSlotCount.load(std::memory_order_relaxed);
+        std::size_t chunkIndex = index / FILE_SLOT_CHUNK_SIZE;
+        if(chunkIndex == MAX_FILE_SLOT_CHUNKS)
+        {
+            throw std::length_error("Too many file names have been interned");
+        }
+
+        if(index % FILE_SLOT_CHUNK_SIZE == 0)
+        {
+            m_fileSlotStorage.push_back(std::make_unique<FileSlot[]>(FILE_SLOT_CHUNK_SIZE));
+            m_fileSlotChunks[chunkIndex].store(m_fileSlotStorage.back().get(), std::memory_order_release);
         }
-        catch(const FileDoesNotExistError&)
+
+        FileSlot& slot = m_fileSlotStorage[chunkIndex][index % FILE_SLOT_CHUNK_SIZE];
+        slot.name = fileName;
+        slot.path = slot.name;
+
+        FileId fileId{index};
+        m_fileIds.emplace(fileName, fileId);
+
+        // publishes the slot's name to lookups that check the id against the count
+        m_fileSlotCount.store(index + 1, std::memory_order_release);
+
+        return fileId;
+    }
+
+    VirtualFS::FileSlot& VirtualFS::getFileSlot(FileId fileId) const
+    {
+        if(fileId.index >= m_fileSlotCount.load(std::memory_order_acquire))
         {
+            throw std::out_of_range("File id has not been interned");
         }
-        
-        return getFileFromDisk(fileName);
+
+        FileSlot* chunk = m_fileSlotChunks[fileId.index / FILE_SLOT_CHUNK_SIZE].load(std::memory_order_acquire);
+        return chunk[fileId.index % FILE_SLOT_CHUNK_SIZE];
+    }
+
+    std::string_view VirtualFS::getFileName(FileId fileId) const
+    {
+        return getFileSlot(fileId).name;
+    }
+
+    File VirtualFS::getFile(FileId fileId)
+    {
+        auto file = tryGetFile(fileId);
+        if(!file)
+        {
+            throw FileDoesNotExistError(getFileName(fileId));
+        }
+
+        return *file;
+    }
+
+    std::optional<File> VirtualFS::tryGetFile(FileId fileId)
+    {
+        FileSlot& slot = getFileSlot(fileId);
+
+        // read before resolving, so a bundle change during the resolution makes the next lookup resolve again
+        std::uint64_t bundleGeneration = m_bundleGeneration.load(std::memory_order_acquire);
+
+        auto resolution = slot.resolution.load(std::memory_order_acquire);
+        if(resolution && resolution->bundleGeneration == bundleGeneration)
+        {
+            // a stale disk file is resolved again by name, which reloads it or finds it gone
+            auto res = resolution->resource.lock();
+            if(res && (!res->isFromDisk() || m_diskManager.isResourceFresh(*res, slot.path)))
+            {
+                return File(std::move(res));
+            }
+        }
+
+        auto res = tryGetResource(slot.name);
+
+        // misses aren't kept so a file that appears later is found
+        if(res)
+        {
+            slot.resolution.store(std::make_shared<const FileResolution>(FileResolution{res, bundleGeneration}), std::memory_order_release);
+        }
+
+        return toOptionalFile(res);
+    }
+
+    std::shared_future<File> VirtualFS::getFileAsync(std::string_view fileName, FileLoadCallback onLoaded)
+    {
+        return queueLoad(fileName, std::move(onLoaded), std::stop_token{});
+    }
+
+    FileLoadAwaitable VirtualFS::loadFile(std::string_view fileName, std::stop_token stopToken, ResumeScheduler scheduler)
+    {
+        return FileLoadAwaitable(*this, fileName, std::move(stopToken), std::move(scheduler));
+    }
+
+    void VirtualFS::PendingLoad::addRequester(std::stop_token stopToken)
+    {
+        if(!stopToken.stop_possible())
+        {
+            required = true;
+        }
+        else if(!required)
+        {
+            stopTokens.push_back(std::move(stopToken));
+        }
+    }
+
+    std::shared_future<File> VirtualFS::queueLoad(std::string_view fileName, FileLoadCallback onLoaded, std::stop_token stopToken)
+    {
+        auto promise = std::make_shared<std::promise<File>>();
+        std::shared_future<File> result;
+
+        {
+            std::scoped_lock<std::mutex> lock{m_pendingLoadsLock};
+
+            auto pendingItr = m_pendingLoads.find(fileName);
+            if(pendingItr != m_pendingLoads.end())
+            {
+                if(onLoaded)
+                {
+                    pendingItr->second.callbacks.push_back(std::move(onLoaded));
+                }
+
+                pendingItr->second.addRequester(std::move(stopToken));
+                return pendingItr->second.result;
+            }
+
+            result = promise->get_future().share();
+
+            PendingLoad& pendingLoad = m_pendingLoads.emplace(std::string(fileName), PendingLoad{result, {}, false, {}}).first->second;
+            if(onLoaded)
+            {
+                pendingLoad.callbacks.push_back(std::move(onLoaded));
+            }
+
+            pendingLoad.addRequester(std::move(stopToken));
+        }
+
+        std::string name(fileName);
+        m_loadWorkers.submit([this, name, promise]() {
+            finishAsyncLoad(name, *promise);
+        }, [this, name, promise]() {
+            cancelAsyncLoad(name, *promise);
+        });
+
+        return result;
+    }
+
+    void VirtualFS::cancelAsyncLoad(const std::string& fileName, std::promise<File>& promise)
+    {
+        std::vector<FileLoadCallback> callbacks;
+        {
+            std::scoped_lock<std::mutex> lock{m_pendingLoadsLock};
+
+            auto pendingItr = m_pendingLoads.find(fileName);
+            if(pendingItr != m_pendingLoads.end())
+            {
+                callbacks = std::move(pendingItr->second.callbacks);
+                m_pendingLoads.erase(pendingItr);
+            }
+        }
+
+        promise.set_exception(std::make_exception_ptr(FileLoadCancelledError(fileName)));
+        for(auto& callback : callbacks)
+        {
+            callback(std::nullopt);
+        }
+    }
+
+    void VirtualFS::finishAsyncLoad(const std::string& fileName, std::promise<File>& promise)
+    {
+        std::vector<FileLoadCallback> cancelledCallbacks;
+        bool cancelled = false;
+        {
+            std::scoped_lock<std::mutex> lock{m_pendingLoadsLock};
+
+            auto pendingItr = m_pendingLoads.find(fileName);
+            if(pendingItr != m_pendingLoads.end() && !pendingItr->second.required &&
+                std::ranges::all_of(pendingItr->second.stopTokens, [](const std::stop_token& token) { return token.stop_requested(); }))
+            {
+                cancelledCallbacks = std::move(pendingItr->second.callbacks);
+                m_pendingLoads.erase(pendingItr);
+                cancelled = true;
+            }
+        }
+
+        if(cancelled)
+        {
+            promise.set_exception(std::make_exception_ptr(FileLoadCancelledError(fileName)));
+            for(auto& callback : cancelledCallbacks)
+            {
+                callback(std::nullopt);
+            }
+
+            return;
+        }
+
+        std::shared_ptr<Resource> res;
+        std::exception_ptr error;
+
+        try
+        {
+            res = tryGetResource(fileName);
+        }
+        catch(...)
+        {
+            error = std::current_exception();
+        }
+
+        if(res)
+        {
+            promise.set_value(File(res));
+        }
+        else
+        {
+            promise.set_exception(error ? error : std::make_exception_ptr(FileDoesNotExistError(fileName)));
+        }
+
+        // later requests start a new load so they see changes made after this one
+        std::vector<FileLoadCallback> callbacks;
+        {
+            std::scoped_lock<std::mutex> lock{m_pendingLoadsLock};
+
+            auto pendingItr = m_pendingLoads.find(fileName);
+            if(pendingItr != m_pendingLoads.end())
+            {
+                callbacks = std::move(pendingItr->second.callbacks);
+                m_pendingLoads.erase(pendingItr);
+            }
+        }
+
+        auto file = toOptionalFile(res);
+        for(auto& callback : callbacks)
+        {
+            callback(file);
+        }
+    }
+
+    void VirtualFS::setLoadThreadCount(std::size_t threadCount)
+    {
+        m_loadWorkers.setThreadCount(threadCount);
+    }
+
+    std::size_t VirtualFS::getLoadThreadCount()
+    {
+        return m_loadWorkers.getThreadCount();
     }
 
     void VirtualFS::setReloadMode(ReloadMode newMode)
@@ -40,37 +429,131 @@ namespace vfs
         m_diskManager.pollForUpdatedFiles();
     }
 
+    void VirtualFS::setFreshnessPolicy(FreshnessPolicy newPolicy)
+    {
+        m_diskManager.setFreshnessPolicy(newPolicy);
+    }
+
+    FreshnessPolicy VirtualFS::getFreshnessPolicy() const
+    {
+        return m_diskManager.getFreshnessPolicy();
+    }
+
+    void VirtualFS::setFreshnessTimeToLive(std::chrono::milliseconds timeToLive)
+    {
+        m_diskManager.setFreshnessTimeToLive(timeToLive);
+    }
+
+    void VirtualFS::setDiskLoadMode(DiskLoadMode newMode)
+    {
+        m_diskManager.setDiskLoadMode(newMode);
+    }
+
+    DiskLoadMode VirtualFS::getDiskLoadMode() const
+    {
+        return m_diskManager.getDiskLoadMode();
+    }
+
+    void VirtualFS::setSequentialReadHint(bool enabled)
+    {
+        m_diskManager.setSequentialReadHint(enabled);
+    }
+
+    bool VirtualFS::getSequentialReadHint() const
+    {
+        return m_diskManager.getSequentialReadHint();
+    }
+
     void VirtualFS::addGlobalBundle(const Bundle& bundle)
     {
         m_bundleManager.addGlobalBundle(bundle);
+        m_bundleGeneration.fetch_add(1, std::memory_order_release);
+        m_changeEpoch->fetch_add(1, std::memory_order_release);
     }
 
-    void VirtualFS::addBundle(const std::string& bundleName, const Bundle& bundle)
+    void VirtualFS::addBundle(std::string_view bundleName, const Bundle& bundle)
     {
         m_bundleManager.addBundle(bundleName, bundle);
+        m_changeEpoch->fetch_add(1, std::memory_order_release);
     }
 
     void VirtualFS::removeGlobalBundle(const Bundle& bundle)
     {
         m_bundleManager.removeGlobalBundle(bundle);
+        m_bundleGeneration.fetch_add(1, std::memory_order_release);
+        m_changeEpoch->fetch_add(1, std::memory_order_release);
     }
 
-    void VirtualFS::removeBundle(const std::string& bundleName)
+    void VirtualFS::removeBundle(std::string_view bundleName)
     {
         m_bundleManager.removeBundle(bundleName);
+        m_changeEpoch->fetch_add(1, std::memory_order_release);
     }
 
-    File VirtualFS::getFileFromGlobalBundle(const std::string& fileName)
+    File VirtualFS::getFileFromGlobalBundle(std::string_view fileName)
     {
         return File(m_bundleManager.getResourceFromGlobalBundle(fileName));
     }
 
-    File VirtualFS::getFileFromMountedBundle(const std::string& bundleName, const std::string& fileName)
+    File VirtualFS::getFileFromMountedBundle(std::string_view bundleName, std::string_view fileName)
     {
         return File(m_bundleManager.getResourceFromMountedBundle(bundleName, fileName));
     }
 
-    VirtualFS::VirtualFS(ReloadMode reloadMode) : m_diskManager(reloadMode)
+    void VirtualFS::setMemoryResource(std::shared_ptr<std::pmr::memory_resource> memoryResource)
+    {
+        m_diskManager.setMemoryResource(std::move(memoryResource));
+    }
+
+    std::shared_ptr<std::pmr::memory_resource> VirtualFS::getMemoryResource() const
+    {
+        return m_diskManager.getMemoryResource();
+    }
+
+    void VirtualFS::setBufferAlignment(std::size_t alignment)
+    {
+        m_diskManager.setBufferAlignment(alignment);
+    }
+
+    std::size_t VirtualFS::getBufferAlignment() const
+    {
+        return m_diskManager.getBufferAlignment();
+    }
+
+    void VirtualFS::setDecompressionCacheSize(std::size_t capacity)
+    {
+        m_bundleManager.setDecompressionCacheSize(capacity);
+    }
+
+    DecompressionCacheStats VirtualFS::getDecompressionCacheStats() const
+    {
+        return m_bundleManager.getDecompressionCacheStats();
+    }
+
+    void VirtualFS::setWriteBehind(bool enabled)
+    {
+        m_diskManager.setWriteBehind(enabled);
+    }
+
+    bool VirtualFS::getWriteBehind() const
+    {
+        return m_diskManager.getWriteBehind();
+    }
+
+    void VirtualFS::flushWrites()
+    {
+        m_diskManager.flushWrites();
+    }
+
+    std::uint64_t VirtualFS::getChangeEpoch() const
+    {
+        return m_changeEpoch->load(std::memory_order_acquire);
+    }
+
+    VirtualFS::VirtualFS(ReloadMode reloadMode) : 
+        m_changeEpoch(std::make_shared<ChangeCounter>(0)),
+        m_diskManager(reloadMode, m_changeEpoch),
+        m_loadWorkers(defaultLoadThreadCount())
     {
     }
 }
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include "vfs_awaitable.hpp"
+
+#include "vfs.hpp"
+
+namespace vfs
+{
+    void FileLoadAwaitable::LoadState::finish(std::optional<File> loadedFile, bool wasCancelled)
+    {
+        // only the first of the load and the cancellation gets to finish
+        if(finished.exchange(true))
+        {
+            return;
+        }
+
+        file = std::move(loadedFile);
+        cancelled = wasCancelled;
+
+        if(remainingSteps.fetch_sub(1) == 1)
+        {
+            resume();
+        }
+    }
+
+    void FileLoadAwaitable::LoadState::resume()
+    {
+        if(scheduler)
+        {
+            scheduler(handle);
+        }
+        else
+        {
+            handle.resume();
+        }
+    }
+
+    void FileLoadAwaitable::CancelLoad::operator()() const
+    {
+        state->finish(std::nullopt, true);
+    }
+
+    bool FileLoadAwaitable::await_ready() const noexcept
+    {
+        return m_stopToken.stop_requested();
+    }
+
+    bool FileLoadAwaitable::await_suspend(std::coroutine_handle<> handle)
+    {
+        m_state->handle = handle;
+
+        // keep the state alive for the loader thread even if the coroutine is destroyed after a cancellation
+        m_state->result = m_fs.queueLoad(m_fileName, [state = m_state](std::optional<File> file) {
+            state->finish(std::move(file), false);
+        }, m_stopToken);
+
+        // runs inline if a stop was requested since await_ready
+        m_stopCallback.emplace(m_stopToken, CancelLoad{m_state});
+
+        if(m_state->remainingSteps.fetch_sub(1) != 1)
+        {
+            return true;
+        }
+
+        // finished before we got here, no need to bounce through the scheduler without one
+        if(!m_state->scheduler)
+        {
+            return false;
+        }
+
+        m_state->resume();
+        return true;
+    }
+
+    File FileLoadAwaitable::await_resume()
+    {
+        m_stopCallback.reset();
+
+        // never suspended because the stop was already requested
+        if(!m_state->handle || m_state->cancelled)
+        {
+            throw FileLoadCancelledError(m_fileName);
+        }
+
+        if(m_state->file)
+        {
+            return *m_state->file;
+        }
+
+        // rethrows whatever the load failed with, a missing file is FileDoesNotExistError
+        return m_state->result.get();
+    }
+
+    FileLoadAwaitable::FileLoadAwaitable(VirtualFS& fs, std::string_view fileName, std::stop_token stopToken, ResumeScheduler scheduler) :
+        m_fs(fs),
+        m_fileName(fileName),
+        m_stopToken(std::move(stopToken)),
+        m_state(std::make_shared<LoadState>())
+    {
+        m_state->scheduler = std::move(scheduler);
+    }
+}
@@ -0,0 +1,489 @@
+#include "vfs_resource.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <thread>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define VFS_HAS_IO_URING
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace vfs
+{
+    static void loadOnThreads(std::span<const std::string> filePaths, const DiskLoadOptions& loadOptions, std::vector<std::optional<DiskData>>& results)
+    {
+        std::size_t threadCount = std::min<std::size_t>(std::clamp<std::size_t>(std::thread::hardware_concurrency(), 1, 8), filePaths.size());
+
+        // each file is claimed by exactly one thread so results can be written without a lock
+        std::atomic<std::size_t> nextFile = 0;
+        auto loadFiles = [&]() {
+            for(std::size_t i = nextFile++; i < filePaths.size(); i = nextFile++)
+            {
+                // an exception would reach std::terminate on a worker thread, the file is left as not loaded instead
+                try
+                {
+                    results[i] = tryLoadDiskData(filePaths[i], loadOptions);
+                }
+                catch(...)
+                {
+                    results[i] = std::nullopt;
+                }
+            }
+        };
+
+        std::vector<std::jthread> workers;
+        for(std::size_t i = 1; i < threadCount; i++)
+        {
+            workers.emplace_back(loadFiles);
+        }
+
+        loadFiles();
+    }
+
+#ifdef VFS_HAS_IO_URING
+    /**
+     * @brief A minimal io_uring instance driven through the raw system calls
+     * Submissions are published in submitAndWait, completions must be drained before submitting more than the ring holds.
+     */
+    class IoUring final
+    {
+    private:
+        int m_fd = -1;
+
+        void* m_sqRing = MAP_FAILED;
+        std::size_t m_sqRingSize = 0;
+        void* m_cqRing = MAP_FAILED;
+        std::size_t m_cqRingSize = 0;
+        void* m_sqeMemory = MAP_FAILED;
+        std::size_t m_sqeMemorySize = 0;
+
+        unsigned* m_sqHead = nullptr;
+        unsigned* m_sqTail = nullptr;
+        unsigned* m_sqArray = nullptr;
+        unsigned m_sqMask = 0;
+        unsigned m_sqEntries = 0;
+        io_uring_sqe* m_sqes = nullptr;
+
+        unsigned* m_cqHead = nullptr;
+        unsigned* m_cqTail = nullptr;
+        unsigned m_cqMask = 0;
+        io_uring_cqe* m_cqes = nullptr;
+
+        unsigned m_localTail = 0;
+        unsigned m_unsubmitted = 0;
+
+        template<typename T>
+        static T* ringField(void* ring, std::uint32_t offset)
+        {
+            return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+        }
+
+    public:
+        bool setup(unsigned entries)
+        {
+            io_uring_params params;
+            std::memset(&params, 0, sizeof(params));
+
+            m_fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+            if(m_fd < 0)
+            {
+                return false;
+            }
+
+            m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+            // newer kernels share one mapping between both rings
+            bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if(singleMap)
+            {
+                m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+            }
+
+            m_sqRing = ::mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+            if(m_sqRing == MAP_FAILED)
+            {
+                return false;
+            }
+
+            if(singleMap)
+            {
+                m_cqRing = m_sqRing;
+            }
+            else
+            {
+                m_cqRing = ::mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+                if(m_cqRing == MAP_FAILED)
+                {
+                    return false;
+                }
+            }
+
+            m_sqeMemorySize = params.sq_entries * sizeof(io_uring_sqe);
+            m_sqeMemory = ::mmap(nullptr, m_sqeMemorySize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+            if(m_sqeMemory == MAP_FAILED)
+            {
+                return false;
+            }
+
+            m_sqHead = ringField<unsigned>(m_sqRing, params.sq_off.head);
+            m_sqTail = ringField<unsigned>(m_sqRing, params.sq_off.tail);
+            m_sqArray = ringField<unsigned>(m_sqRing, params.sq_off.array);
+            m_sqMask = *ringField<unsigned>(m_sqRing, params.sq_off.ring_mask);
+            m_sqEntries = params.sq_entries;
+            m_sqes = static_cast<io_uring_sqe*>(m_sqeMemory);
+
+            m_cqHead = ringField<unsigned>(m_cqRing, params.cq_off.head);
+            m_cqTail = ringField<unsigned>(m_cqRing, params.cq_off.tail);
+            m_cqMask = *ringField<unsigned>(m_cqRing, params.cq_off.ring_mask);
+            m_cqes = ringField<io_uring_cqe>(m_cqRing, params.cq_off.cqes);
+
+            m_localTail = *m_sqTail;
+            return true;
+        }
+
+        bool supports(std::initializer_list<unsigned> opcodes) const
+        {
+            constexpr unsigned PROBE_OPS = 256;
+
+            std::vector<byte_t> probeMemory(sizeof(io_uring_probe) + PROBE_OPS * sizeof(io_uring_probe_op));
+            auto* probe = reinterpret_cast<io_uring_probe*>(probeMemory.data());
+
+            if(::syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_PROBE, probe, PROBE_OPS) < 0)
+            {
+                return false;
+            }
+
+            return std::ranges::all_of(opcodes, [probe](unsigned opcode) {
+                return opcode < probe->ops_len && (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) != 0;
+            });
+        }
+
+        unsigned getCapacity() const
+        {
+            return m_sqEntries;
+        }
+
+        bool queue(const io_uring_sqe& entry)
+        {
+            unsigned head = std::atomic_ref<unsigned>(*m_sqHead).load(std::memory_order_acquire);
+            if(m_localTail - head >= m_sqEntries)
+            {
+                return false;
+            }
+
+            unsigned index = m_localTail & m_sqMask;
+            m_sqes[index] = entry;
+            m_sqArray[index] = index;
+            m_localTail++;
+            m_unsubmitted++;
+
+            return true;
+        }
+
+        bool submitAndWait(unsigned waitCount)
+        {
+            std::atomic_ref<unsigned>(*m_sqTail).store(m_localTail, std::memory_order_release);
+
+            while(m_unsubmitted > 0 || waitCount > 0)
+            {
+                long submitted = ::syscall(__NR_io_uring_enter, m_fd, m_unsubmitted, waitCount, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if(submitted < 0)
+                {
+                    // the completion queue being full only delays the submission
+                    if(errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                    {
+                        continue;
+                    }
+
+                    return false;
+                }
+
+                m_unsubmitted -= static_cast<unsigned>(submitted);
+                waitCount = 0;
+            }
+
+            return true;
+        }
+
+        bool popCompletion(io_uring_cqe& completion)
+        {
+            unsigned head = *m_cqHead;
+            if(head == std::atomic_ref<unsigned>(*m_cqTail).load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            completion = m_cqes[head & m_cqMask];
+            std::atomic_ref<unsigned>(*m_cqHead).store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        IoUring() = default;
+        IoUring(const IoUring&) = delete;
+        IoUring& operator=(const IoUring&) = delete;
+
+        ~IoUring()
+        {
+            if(m_sqeMemory != MAP_FAILED)
+            {
+                ::munmap(m_sqeMemory, m_sqeMemorySize);
+            }
+
+            if(m_cqRing != MAP_FAILED && m_cqRing != m_sqRing)
+            {
+                ::munmap(m_cqRing, m_cqRingSize);
+            }
+
+            if(m_sqRing != MAP_FAILED)
+            {
+                ::munmap(m_sqRing, m_sqRingSize);
+            }
+
+            if(m_fd >= 0)
+            {
+                ::close(m_fd);
+            }
+        }
+    };
+
+    /**
+     * @brief The in flight state of one file in an io_uring batch
+     */
+    struct UringFile
+    {
+        int fd = -1;
+        bool statted = false;
+        struct stat stat;
+        ByteBuffer data;
+        std::size_t bytesRead = 0;
+        bool failed = false;
+
+        UringFile(std::pmr::memory_resource* memoryResource) : data(memoryResource) {}
+        UringFile(const UringFile&) = delete;
+        UringFile& operator=(const UringFile&) = delete;
+
+        ~UringFile()
+        {
+            if(fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+    };
+
+    static bool loadChunkWithUring(IoUring& ring, std::span<const std::string> filePaths, std::span<std::optional<DiskData>> results, const DiskLoadOptions& loadOptions)
+    {
+        // the buffers get their memory resource up front, assigning a buffer from another resource later would copy it
+        std::deque<UringFile> files;
+        for(std::size_t i = 0; i < filePaths.size(); i++)
+        {
+            files.emplace_back(loadOptions.getMemoryResource());
+        }
+
+        // open every file of the chunk in one submission, user data is the file index
+        for(std::size_t i = 0; i < filePaths.size(); i++)
+        {
+            io_uring_sqe openEntry{};
+            openEntry.opcode = IORING_OP_OPENAT;
+            openEntry.fd = AT_FDCWD;
+            openEntry.addr = reinterpret_cast<std::uint64_t>(filePaths[i].c_str());
+            openEntry.open_flags = O_RDONLY | O_CLOEXEC;
+            openEntry.user_data = i;
+
+            if(!ring.queue(openEntry))
+            {
+                return false;
+            }
+        }
+
+        unsigned pending = static_cast<unsigned>(filePaths.size());
+        if(!ring.submitAndWait(pending))
+        {
+            return false;
+        }
+
+        io_uring_cqe completion;
+        while(pending > 0)
+        {
+            if(!ring.popCompletion(completion))
+            {
+                if(!ring.submitAndWait(1))
+                {
+                    return false;
+                }
+
+                continue;
+            }
+
+            pending--;
+
+            // statx can't complete inline and gets handed to a kernel worker, fstat on the open descriptor is cheaper
+            UringFile& file = files[completion.user_data];
+            file.fd = completion.res;
+            if(file.fd >= 0)
+            {
+                file.statted = ::fstat(file.fd, &file.stat) == 0;
+            }
+        }
+
+        // then read every file that could be opened, short reads are queued again for the rest of the file
+        std::vector<std::size_t> toRead;
+        for(std::size_t i = 0; i < files.size(); i++)
+        {
+            UringFile& file = files[i];
+            if(file.fd < 0 || !file.statted)
+            {
+                file.failed = true;
+                continue;
+            }
+
+            file.data.resize(static_cast<std::size_t>(file.stat.st_size));
+            if(!file.data.empty())
+            {
+                toRead.push_back(i);
+            }
+        }
+
+        while(!toRead.empty())
+        {
+            for(std::size_t i : toRead)
+            {
+                UringFile& file = files[i];
+
+                // a single read is limited to 32 bits of length
+                std::size_t remaining = std::min<std::size_t>(file.data.size() - file.bytesRead, 1u << 30);
+
+                io_uring_sqe readEntry{};
+                readEntry.opcode = IORING_OP_READ;
+                readEntry.fd = file.fd;
+                readEntry.addr = reinterpret_cast<std::uint64_t>(file.data.data() + file.bytesRead);
+                readEntry.len = static_cast<std::uint32_t>(remaining);
+                readEntry.off = file.bytesRead;
+                readEntry.user_data = i;
+
+                if(!ring.queue(readEntry))
+                {
+                    return false;
+                }
+            }
+
+            pending = static_cast<unsigned>(toRead.size());
+            toRead.clear();
+
+            if(!ring.submitAndWait(pending))
+            {
+                return false;
+            }
+
+            while(pending > 0)
+            {
+                if(!ring.popCompletion(completion))
+                {
+                    if(!ring.submitAndWait(1))
+                    {
+                        return false;
+                    }
+
+                    continue;
+                }
+
+                pending--;
+
+                UringFile& file = files[completion.user_data];
+                if(completion.res == -EINTR || completion.res == -EAGAIN)
+                {
+                    toRead.push_back(completion.user_data);
+                }
+                else if(completion.res < 0)
+                {
+                    file.failed = true;
+                }
+                else if(completion.res == 0)
+                {
+                    // the file was truncated since it was stat'ed
+                    file.data.resize(file.bytesRead);
+                }
+                else
+                {
+                    file.bytesRead += static_cast<std::size_t>(completion.res);
+                    if(file.bytesRead < file.data.size())
+                    {
+                        toRead.push_back(completion.user_data);
+                    }
+                }
+            }
+        }
+
+        for(std::size_t i = 0; i < files.size(); i++)
+        {
+            UringFile& file = files[i];
+            if(file.failed)
+            {
+                continue;
+            }
+
+            // constructed in place so the buffer keeps its memory resource
+            results[i].emplace(DiskData{filePaths[i], std::move(file.data), toTimePoint(file.stat.st_mtim), loadOptions, {}, {}});
+        }
+
+        return true;
+    }
+
+    static bool loadWithUring(std::span<const std::string> filePaths, const DiskLoadOptions& loadOptions, std::vector<std::optional<DiskData>>& results)
+    {
+        constexpr unsigned RING_ENTRIES = 256;
+
+        IoUring ring;
+        if(!ring.setup(RING_ENTRIES) || !ring.supports({IORING_OP_OPENAT, IORING_OP_READ}))
+        {
+            return false;
+        }
+
+        // a chunk fills the ring, which also bounds the number of open descriptors
+        std::size_t chunkSize = ring.getCapacity();
+        for(std::size_t first = 0; first < filePaths.size(); first += chunkSize)
+        {
+            std::size_t count = std::min(chunkSize, filePaths.size() - first);
+            if(!loadChunkWithUring(ring, filePaths.subspan(first, count), std::span(results).subspan(first, count), loadOptions))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+#endif
+
+    std::vector<std::optional<DiskData>> tryLoadDiskDataBatch(std::span<const std::string> filePaths, const DiskLoadOptions& loadOptions)
+    {
+        std::vector<std::optional<DiskData>> results(filePaths.size());
+        if(filePaths.empty())
+        {
+            return results;
+        }
+
+#ifdef VFS_HAS_IO_URING
+        // mapping a file needs no reads so there is nothing to batch
+        if(loadOptions.mode == DiskLoadMode::COPY && loadWithUring(filePaths, loadOptions, results))
+        {
+            return results;
+        }
+
+        // a ring that fails part way leaves some files loaded, the rest are loaded below
+        std::fill(results.begin(), results.end(), std::nullopt);
+#endif
+
+        loadOnThreads(filePaths, loadOptions, results);
+        return results;
+    }
+}
@@ -1,5 +1,12 @@
 #include "vfs_bundle.hpp"
 
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "vfs_pack.hpp"
+
 namespace vfs
 {
     static void disownResource(std::weak_ptr<Resource>& resPtr)
@@ -11,163 +18,605 @@ namespace vfs
         }
     }
 
-    static const std::span<const byte_t> getDataFromBundle(const Bundle& bundle, const std::string& fileName)
+    static const std::span<const byte_t> getDataFromBundle(std::span<const byte_t> blob, const FileTableEntry& entry)
+    {
+        auto startByte = blob.begin() + static_cast<long>(entry.startByte);
+        auto endByte = startByte + static_cast<long>(entry.length);
+
+        return std::span<const byte_t>(startByte, endByte);
+    }
+
+    static FileTableEntry toFileTableEntry(const FileIndexEntry& entry)
     {
-        if(bundle.files.count(fileName) == 0)
+        return FileTableEntry{static_cast<std::size_t>(entry.startByte), static_cast<std::size_t>(entry.length), entry.compression, static_cast<std::size_t>(entry.uncompressedSize)};
+    }
+
+    static FileTableEntry toFileTableEntry(const CompactFileIndexEntry& entry)
+    {
+        return FileTableEntry{entry.startByte, entry.length};
+    }
+
+    template<typename Entry>
+    static std::optional<FileTableEntry> findIndexedFile(const FileIndex& index, std::span<const Entry> entries, std::string_view fileName)
+    {
+        auto entryItr = std::lower_bound(entries.begin(), entries.end(), fileName, 
+            [&index](const Entry& entry, std::string_view name) { return index.getName(entry) < name; });
+
+        if(entryItr == entries.end() || index.getName(*entryItr) != fileName)
         {
-            throw FileDoesNotExistError(fileName);
+            return std::nullopt;
         }
 
-        const FileTableEntry& entry = bundle.files.at(fileName);
+        return toFileTableEntry(*entryItr);
+    }
 
-        auto startByte = bundle.blob.begin() + static_cast<long>(entry.startByte);
-        auto endByte = startByte + static_cast<long>(entry.length);
+    static std::optional<FileTableEntry> findBundleFile(const Bundle& bundle, std::string_view fileName)
+    {
+        if(bundle.pack)
+        {
+            return bundle.pack->findFile(fileName);
+        }
 
-        return std::span<const byte_t>(startByte, endByte);
+        if(!bundle.index.compactEntries.empty())
+        {
+            return findIndexedFile(bundle.index, bundle.index.compactEntries, fileName);
+        }
+
+        if(!bundle.index.entries.empty())
+        {
+            return findIndexedFile(bundle.index, bundle.index.entries, fileName);
+        }
+
+        auto entryItr = bundle.files.find(fileName);
+        if(entryItr == bundle.files.end())
+        {
+            return std::nullopt;
+        }
+
+        return entryItr->second;
     }
 
-    void BundleManager::addGlobalBundle(const Bundle& bundle)
+    static void forEachIndexedFile(const FileIndex& index, const auto& entries, const auto& callback)
+    {
+        for(const auto& entry : entries)
+        {
+            callback(index.getName(entry), toFileTableEntry(entry));
+        }
+    }
+
+    static void forEachBundleFile(const Bundle& bundle, const auto& callback)
     {
-        // invalidate old files now shadowed by the bundle?
+        if(bundle.pack)
+        {
+            const PackFile& pack = *bundle.pack;
+            for(std::size_t i = 0; i < pack.getFileCount(); i++)
+            {
+                callback(pack.getFileName(i), pack.getFileEntry(i));
+            }
+
+            return;
+        }
+
+        if(bundle.index.getFileCount() != 0)
+        {
+            forEachIndexedFile(bundle.index, bundle.index.compactEntries, callback);
+            forEachIndexedFile(bundle.index, bundle.index.entries, callback);
+            return;
+        }
+
         for(const auto&[fileName, fileEntry] : bundle.files)
         {
-            if(m_globalBundleResources.count(fileName) > 0)
+            callback(std::string_view(fileName), fileEntry);
+        }
+    }
+
+    /**
+     * @brief The names and entries of an index built at runtime, only one of the entry arrays is filled
+     */
+    struct IndexStorage
+    {
+        std::string names;
+        std::vector<FileIndexEntry> entries;
+        std::vector<CompactFileIndexEntry> compactEntries;
+    };
+
+    Bundle makeIndexedBundle(std::span<const byte_t> blob, std::span<const std::pair<std::string_view, FileTableEntry>> files, std::size_t alignment)
+    {
+        static constexpr std::uint64_t COMPACT_LIMIT = std::numeric_limits<std::uint32_t>::max();
+
+        // a stable sort keeps the first of any names that are given twice first, the rest are dropped
+        std::vector<std::size_t> sortedFiles(files.size());
+        std::iota(sortedFiles.begin(), sortedFiles.end(), std::size_t{0});
+        std::stable_sort(sortedFiles.begin(), sortedFiles.end(), [&files](std::size_t left, std::size_t right) { return files[left].first < files[right].first; });
+
+        sortedFiles.erase(std::unique(sortedFiles.begin(), sortedFiles.end(),
+            [&files](std::size_t left, std::size_t right) { return files[left].first == files[right].first; }), sortedFiles.end());
+
+        auto storage = std::make_shared<IndexStorage>();
+
+        bool compact = true;
+        for(std::size_t i : sortedFiles)
+        {
+            const auto&[fileName, fileEntry] = files[i];
+            storage->names += fileName;
+            compact = compact && fileEntry.compression == CompressionMethod::NONE &&
+                fileEntry.startByte <= COMPACT_LIMIT && fileEntry.length <= COMPACT_LIMIT - fileEntry.startByte;
+        }
+
+        if(storage->names.size() > COMPACT_LIMIT)
+        {
+            throw std::length_error("File names are too long for a file index");
+        }
+
+        std::size_t nameOffset = 0;
+        for(std::size_t i : sortedFiles)
+        {
+            const auto&[fileName, fileEntry] = files[i];
+            auto offset = static_cast<std::uint32_t>(nameOffset);
+            auto length = static_cast<std::uint32_t>(fileName.size());
+
+            if(compact)
+            {
+                storage->compactEntries.push_back(CompactFileIndexEntry{offset, length, static_cast<std::uint32_t>(fileEntry.startByte), static_cast<std::uint32_t>(fileEntry.length)});
+            }
+            else
             {
-                auto&[bundlePtr, resource] = m_globalBundleResources.at(fileName);
-                disownResource(resource);
-                m_globalBundleResources.erase(fileName);
+                storage->entries.push_back(FileIndexEntry{offset, length, fileEntry.startByte, fileEntry.length, fileEntry.uncompressedSize, fileEntry.compression});
             }
+
+            nameOffset += fileName.size();
         }
 
-        m_globalBundles.insert(m_globalBundles.begin(), bundle);
+        FileIndex index{storage->names, storage->entries, storage->compactEntries};
+        return Bundle{blob, {}, alignment, index, nullptr, std::move(storage)};
     }
 
-    void BundleManager::disownMountedBundle(const std::string& bundleName)
+    bool BundleManager::BundleFileSource::isSameFile(const Bundle& bundle, const FileTableEntry& fileEntry) const
     {
-        auto& oldBundleResources = m_mountedBundleResources.at(bundleName);  
-        for(auto& resourceEntry : oldBundleResources)
+        return bundle.blob.data() == blob.data() && bundle.blob.size() == blob.size() && fileEntry == entry;
+    }
+
+    std::shared_ptr<Resource> BundleManager::makeBundleResource(const BundleFileSource& source)
+    {
+        auto data = getDataFromBundle(source.blob, source.entry);
+        if(source.entry.compression == CompressionMethod::NONE)
         {
-            disownResource(resourceEntry.second);
+            return std::make_shared<Resource>(data, source.pack);
+        }
+
+        if(source.entry.compression != CompressionMethod::LZ)
+        {
+            throw DecompressionError();
+        }
+
+        // the decompressed buffer owns the contents, so the bundle itself no longer has to outlive them
+        auto decompressed = m_decompressionCache.getOrDecompress(data, source.entry.uncompressedSize);
+        return std::make_shared<Resource>(std::span<const byte_t>(*decompressed), decompressed);
+    }
+
+    BundleManager::GlobalIndexShard& BundleManager::getGlobalIndexShard(std::string_view fileName)
+    {
+        return m_globalIndexShards[StringHash{}(fileName) % GLOBAL_INDEX_SHARD_COUNT];
+    }
+
+    void BundleManager::addGlobalBundle(const Bundle& bundle)
+    {
+        // the whole index is read anyway, checking it first means a corrupt pack can't be left half added
+        if(bundle.pack)
+        {
+            bundle.pack->validateIndex();
         }
 
-        m_mountedBundleResources.erase(bundleName);
+        std::scoped_lock<std::mutex> bundlesLock{m_globalBundlesLock};
+
+        const Bundle& addedBundle = m_globalBundles.emplace_front(bundle);
+
+        forEachBundleFile(addedBundle, [&](std::string_view fileName, const FileTableEntry& fileEntry) {
+            GlobalIndexShard& shard = getGlobalIndexShard(fileName);
+            std::unique_lock<std::shared_mutex> shardLock{shard.lock};
+
+            auto indexItr = shard.entries.find(fileName);
+            if(indexItr != shard.entries.end())
+            {
+                // invalidate old files now shadowed by the bundle
+                disownResource(indexItr->second.resource);
+                indexItr->second = GlobalBundleEntry{&addedBundle, fileEntry, {}};
+            }
+            else
+            {
+                shard.entries.emplace(fileName, GlobalBundleEntry{&addedBundle, fileEntry, {}});
+            }
+        });
     }
 
-    void BundleManager::addBundle(const std::string& bundleName, const Bundle& bundle)
+    void BundleManager::disownMountedBundle(MountedBundle& mountedBundle)
     {
-        // invalidate old bundle if it existed files
-        if(m_mountedBundleResources.count(bundleName) > 0)
+        for(auto& resourceEntry : mountedBundle.resources)
         {
-            disownMountedBundle(bundleName);
+            disownResource(resourceEntry.second);
         }
 
-        m_mountedBundles[bundleName] = bundle;
+        mountedBundle.resources.clear();
     }
 
-    void BundleManager::removeBundle(const std::string& bundleName)
+    void BundleManager::addBundle(std::string_view bundleName, const Bundle& bundle)
     {
-        if(m_mountedBundleResources.count(bundleName) > 0)
+        std::unique_lock<std::shared_mutex> lock{m_mountedBundlesLock};
+
+        auto bundleItr = m_mountedBundles.find(bundleName);
+        if(bundleItr != m_mountedBundles.end())
         {
-            disownMountedBundle(bundleName);
+            // invalidate old bundle files
+            disownMountedBundle(bundleItr->second);
+            m_decompressionCache.evict(bundleItr->second.bundle.blob);
+            bundleItr->second.bundle = bundle;
         }
+        else
+        {
+            m_mountedBundles.emplace(bundleName, MountedBundle{bundle, {}});
+        }
+    }
 
-        m_mountedBundles.erase(bundleName);
+    void BundleManager::removeBundle(std::string_view bundleName)
+    {
+        std::unique_lock<std::shared_mutex> lock{m_mountedBundlesLock};
+
+        auto bundleItr = m_mountedBundles.find(bundleName);
+        if(bundleItr != m_mountedBundles.end())
+        {
+            disownMountedBundle(bundleItr->second);
+            m_decompressionCache.evict(bundleItr->second.bundle.blob);
+            m_mountedBundles.erase(bundleItr);
+        }
     }
 
     static bool operator==(const Bundle& left, const Bundle& right)
     {
         return left.files == right.files && 
                left.blob.data() == right.blob.data() && 
-               left.blob.size() == right.blob.size();
+               left.blob.size() == right.blob.size() &&
+               left.index.names.data() == right.index.names.data() &&
+               left.index.entries.data() == right.index.entries.data() &&
+               left.index.compactEntries.data() == right.index.compactEntries.data() &&
+               left.pack == right.pack;
     }
 
     void BundleManager::removeGlobalBundle(const Bundle& bundle)
     {
-        auto bundleItr = std::find(m_globalBundles.begin(), m_globalBundles.end(), bundle);
-        const Bundle* bundle_ptr = &(*bundleItr);
+        std::scoped_lock<std::mutex> bundlesLock{m_globalBundlesLock};
 
-        for(auto itr = m_globalBundleResources.begin(); itr != m_globalBundleResources.end();)
+        auto bundleItr = std::find(m_globalBundles.begin(), m_globalBundles.end(), bundle);
+        if(bundleItr == m_globalBundles.end())
         {
-            auto&[fileName, filePair] = *itr;
-            auto&[itrBundlePtr, file] = filePair;
+            return;
+        }
+
+        const Bundle* bundlePtr = &(*bundleItr);
 
-            if(itrBundlePtr == bundle_ptr)
+        forEachBundleFile(*bundlePtr, [&](std::string_view fileName, const FileTableEntry&) {
+            GlobalIndexShard& shard = getGlobalIndexShard(fileName);
+            std::unique_lock<std::shared_mutex> shardLock{shard.lock};
+
+            auto indexItr = shard.entries.find(fileName);
+            if(indexItr == shard.entries.end() || indexItr->second.bundle != bundlePtr)
             {
-                auto res = file.lock();
-                if(res)
+                return;
+            }
+
+            disownResource(indexItr->second.resource);
+
+            // fall back to the next highest priority bundle that provides the file
+            bool foundFallback = false;
+            for(auto fallbackItr = std::next(bundleItr); fallbackItr != m_globalBundles.end(); fallbackItr++)
+            {
+                auto fallbackEntry = findBundleFile(*fallbackItr, fileName);
+                if(fallbackEntry)
                 {
-                    res->disown();
+                    indexItr->second = GlobalBundleEntry{&(*fallbackItr), *fallbackEntry, {}};
+                    foundFallback = true;
+                    break;
                 }
-                itr = m_globalBundleResources.erase(itr);
             }
-            else
+
+            if(!foundFallback)
             {
-                itr++;
+                shard.entries.erase(indexItr);
             }
+        });
 
+        // no index entry refers to the bundle anymore so readers can no longer reach it
+        m_decompressionCache.evict(bundlePtr->blob);
+        m_globalBundles.erase(bundleItr);
+    }
+
+    std::shared_ptr<Resource> BundleManager::getResourceFromGlobalBundle(std::string_view fileName)
+    {
+        auto res = tryGetResourceFromGlobalBundle(fileName);
+        if(!res)
+        {
+            throw FileDoesNotExistError(fileName);
         }
 
-        m_globalBundles.erase(bundleItr);
+        return res;
     }
 
-    std::shared_ptr<Resource> BundleManager::getResourceFromGlobalBundle(const std::string& fileName)
+    std::shared_ptr<Resource> BundleManager::getResourceFromMountedBundle(std::string_view bundleName, std::string_view fileName)
     {
-        // check already loaded bundle resources
-        if(m_globalBundleResources.count(fileName) > 0)
+        auto res = tryGetResourceFromMountedBundle(bundleName, fileName);
+        if(!res)
         {
-            auto res = m_globalBundleResources.at(fileName).second.lock();
+            bool bundleExists;
+            {
+                std::shared_lock<std::shared_mutex> lock{m_mountedBundlesLock};
+                bundleExists = m_mountedBundles.contains(bundleName);
+            }
+
+            if(!bundleExists)
+            {
+                throw BundleDoesNotExistError(bundleName);
+            }
+
+            throw FileDoesNotExistError(fileName);
+        }
+
+        return res;
+    }
+
+    std::shared_ptr<Resource> BundleManager::tryGetResourceFromGlobalBundle(std::string_view fileName)
+    {
+        GlobalIndexShard& shard = getGlobalIndexShard(fileName);
+
+        while(true)
+        {
+            // check already loaded bundle resource
+            BundleFileSource source;
+            {
+                std::shared_lock<std::shared_mutex> lock{shard.lock};
+
+                auto indexItr = shard.entries.find(fileName);
+                if(indexItr == shard.entries.end())
+                {
+                    return nullptr;
+                }
+
+                const GlobalBundleEntry& globalEntry = indexItr->second;
+
+                auto res = globalEntry.resource.lock();
+                if(res)
+                {
+                    return res;
+                }
+
+                source = BundleFileSource{globalEntry.bundle->blob, globalEntry.bundle->pack, globalEntry.entry};
+            }
+
+            // otherwise create the resource without the lock, decompressing can take a while
+            auto bundleFile = makeBundleResource(source);
+
+            // rechecking as another thread may have got there first or the file may have been replaced meanwhile
+            std::unique_lock<std::shared_mutex> lock{shard.lock};
+
+            auto indexItr = shard.entries.find(fileName);
+            if(indexItr == shard.entries.end())
+            {
+                return nullptr;
+            }
+
+            GlobalBundleEntry& globalEntry = indexItr->second;
+
+            auto res = globalEntry.resource.lock();
             if(res)
             {
                 return res;
             }
+
+            if(source.isSameFile(*globalEntry.bundle, globalEntry.entry))
+            {
+                globalEntry.resource = bundleFile;
+                return bundleFile;
+            }
+        }
+    }
+
+    std::vector<std::shared_ptr<Resource>> BundleManager::tryGetResourcesFromGlobalBundle(std::span<const std::string_view> fileNames)
+    {
+        std::vector<std::shared_ptr<Resource>> resources(fileNames.size());
+
+        // counting sort the names by shard so every shard's names are next to each other
+        std::vector<std::uint8_t> fileShards(fileNames.size());
+        std::array<std::size_t, GLOBAL_INDEX_SHARD_COUNT + 1> shardStarts{};
+        for(std::size_t i = 0; i < fileNames.size(); i++)
+        {
+            fileShards[i] = static_cast<std::uint8_t>(StringHash{}(fileNames[i]) % GLOBAL_INDEX_SHARD_COUNT);
+            shardStarts[fileShards[i] + 1u]++;
+        }
+
+        for(std::size_t shardIndex = 0; shardIndex < GLOBAL_INDEX_SHARD_COUNT; shardIndex++)
+        {
+            shardStarts[shardIndex + 1] += shardStarts[shardIndex];
+        }
+
+        std::vector<std::size_t> sortedFiles(fileNames.size());
+        {
+            auto shardEnds = shardStarts;
+            for(std::size_t i = 0; i < fileNames.size(); i++)
+            {
+                sortedFiles[shardEnds[fileShards[i]]++] = i;
+            }
         }
 
-        // check global bundles
-        for(const Bundle& bundle : m_globalBundles)
+        std::vector<std::size_t> toCreate;
+        std::vector<BundleFileSource> sources;
+        std::vector<std::size_t> replaced;
+        for(std::size_t shardIndex = 0; shardIndex < GLOBAL_INDEX_SHARD_COUNT; shardIndex++)
         {
-            try
+            std::span<const std::size_t> files{sortedFiles.data() + shardStarts[shardIndex], sortedFiles.data() + shardStarts[shardIndex + 1]};
+            if(files.empty())
             {
-                auto bundleFile = std::make_shared<Resource>(getDataFromBundle(bundle, fileName));
-                m_globalBundleResources[fileName] = std::make_pair(&bundle, bundleFile);
-                
-                return bundleFile;
+                continue;
+            }
+
+            GlobalIndexShard& shard = m_globalIndexShards[shardIndex];
+            toCreate.clear();
+            sources.clear();
+
+            // check already loaded bundle resources
+            {
+                std::shared_lock<std::shared_mutex> lock{shard.lock};
+
+                for(std::size_t i : files)
+                {
+                    auto indexItr = shard.entries.find(fileNames[i]);
+                    if(indexItr == shard.entries.end())
+                    {
+                        continue;
+                    }
+
+                    const GlobalBundleEntry& globalEntry = indexItr->second;
+
+                    resources[i] = globalEntry.resource.lock();
+                    if(!resources[i])
+                    {
+                        toCreate.push_back(i);
+                        sources.push_back(BundleFileSource{globalEntry.bundle->blob, globalEntry.bundle->pack, globalEntry.entry});
+                    }
+                }
+            }
+
+            if(toCreate.empty())
+            {
+                continue;
             }
-            catch(const FileDoesNotExistError&)
+
+            // otherwise create the resources without the lock, decompressing can take a while
+            for(std::size_t j = 0; j < toCreate.size(); j++)
             {
+                resources[toCreate[j]] = makeBundleResource(sources[j]);
+            }
+
+            // rechecking as another thread may have got there first or the file may have been replaced meanwhile
+            std::unique_lock<std::shared_mutex> lock{shard.lock};
+
+            for(std::size_t j = 0; j < toCreate.size(); j++)
+            {
+                std::size_t i = toCreate[j];
+
+                auto indexItr = shard.entries.find(fileNames[i]);
+                if(indexItr == shard.entries.end())
+                {
+                    resources[i] = nullptr;
+                    continue;
+                }
+
+                GlobalBundleEntry& globalEntry = indexItr->second;
+
+                auto res = globalEntry.resource.lock();
+                if(res)
+                {
+                    resources[i] = std::move(res);
+                }
+                else if(sources[j].isSameFile(*globalEntry.bundle, globalEntry.entry))
+                {
+                    globalEntry.resource = resources[i];
+                }
+                else
+                {
+                    replaced.push_back(i);
+                }
             }
         }
 
-        throw FileDoesNotExistError(fileName);
+        // files replaced while they were being made are looked up again on their own
+        for(std::size_t i : replaced)
+        {
+            resources[i] = tryGetResourceFromGlobalBundle(fileNames[i]);
+        }
+
+        return resources;
     }
 
-    std::shared_ptr<Resource> BundleManager::getResourceFromMountedBundle(const std::string& bundleName, const std::string& fileName)
+    std::shared_ptr<Resource> BundleManager::tryGetResourceFromMountedBundle(std::string_view bundleName, std::string_view fileName)
     {
-        // check already loaded bundle resources
-        if(m_mountedBundleResources.count(bundleName) > 0) 
+        while(true)
         {
-            const auto& bundleResources = m_mountedBundleResources.at(bundleName);
+            // check already loaded bundle resources
+            BundleFileSource source;
+            {
+                std::shared_lock<std::shared_mutex> lock{m_mountedBundlesLock};
+
+                auto bundleItr = m_mountedBundles.find(bundleName);
+                if(bundleItr == m_mountedBundles.end())
+                {
+                    return nullptr;
+                }
+
+                const MountedBundle& mountedBundle = bundleItr->second;
+
+                auto loadedItr = mountedBundle.resources.find(fileName);
+                if(loadedItr != mountedBundle.resources.end())
+                {
+                    auto res = loadedItr->second.lock();
+                    if(res)
+                    {
+                        return res;
+                    }
+                }
+
+                auto entry = findBundleFile(mountedBundle.bundle, fileName);
+                if(!entry)
+                {
+                    return nullptr;
+                }
+
+                source = BundleFileSource{mountedBundle.bundle.blob, mountedBundle.bundle.pack, *entry};
+            }
+
+            // otherwise create the resource without the lock, decompressing can take a while
+            auto bundleFile = makeBundleResource(source);
 
-            if(bundleResources.count(fileName) > 0)
+            // rechecking as another thread may have got there first or the bundle may have been replaced meanwhile
+            std::unique_lock<std::shared_mutex> lock{m_mountedBundlesLock};
+
+            auto bundleItr = m_mountedBundles.find(bundleName);
+            if(bundleItr == m_mountedBundles.end())
             {
-                auto res = bundleResources.at(fileName).lock();
+                return nullptr;
+            }
+
+            MountedBundle& mountedBundle = bundleItr->second;
+
+            auto loadedItr = mountedBundle.resources.find(fileName);
+            if(loadedItr != mountedBundle.resources.end())
+            {
+                auto res = loadedItr->second.lock();
                 if(res)
                 {
                     return res;
                 }
             }
-        }
 
-        if(m_mountedBundles.count(bundleName) == 0)
-        {
-            throw BundleDoesNotExistError(bundleName);
-        }
+            auto entry = findBundleFile(mountedBundle.bundle, fileName);
+            if(!entry)
+            {
+                return nullptr;
+            }
 
-        const Bundle& bundle = m_mountedBundles.at(bundleName);
+            if(source.isSameFile(mountedBundle.bundle, *entry))
+            {
+                mountedBundle.resources.insert_or_assign(std::string(fileName), bundleFile);
+                return bundleFile;
+            }
+        }
+    }
 
-        auto bundleFile = std::make_shared<Resource>(getDataFromBundle(bundle, fileName));
-        m_mountedBundleResources[bundleName][fileName] = bundleFile;
+    void BundleManager::setDecompressionCacheSize(std::size_t capacity)
+    {
+        m_decompressionCache.setCapacity(capacity);
+    }
 
-        return bundleFile;
+    DecompressionCacheStats BundleManager::getDecompressionCacheStats() const
+    {
+        return m_decompressionCache.getStats();
     }
 
     BundleManager::BundleManager()
@@ -176,17 +625,17 @@ namespace vfs
 
     BundleManager::~BundleManager()
     {
-        for(auto& globalResource : m_globalBundleResources)
+        for(auto& shard : m_globalIndexShards)
         {
-            disownResource(globalResource.second.second);
+            for(auto& globalEntry : shard.entries)
+            {
+                disownResource(globalEntry.second.resource);
+            }
         }
 
-        for(auto& bundle : m_mountedBundleResources)
+        for(auto& mountedBundle : m_mountedBundles)
         {
-            for(auto& bundleResource : bundle.second)
-            {
-                disownResource(bundleResource.second);
-            }
+            disownMountedBundle(mountedBundle.second);
         }
     }
-}
\ No newline at end of file
+}
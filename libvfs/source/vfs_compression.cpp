@@ -0,0 +1,297 @@
+#include "vfs_compression.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace vfs
+{
+    static constexpr std::size_t MIN_MATCH = 4;
+    static constexpr std::size_t MAX_OFFSET = 65535;
+    static constexpr std::size_t HASH_BITS = 14;
+    static constexpr std::size_t NO_POSITION = std::numeric_limits<std::size_t>::max();
+
+    static std::uint32_t read32(const byte_t* data)
+    {
+        std::uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    static std::size_t hash32(std::uint32_t value)
+    {
+        return (value * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    // writes the extra length bytes of a literal count or match length that didn't fit in the token
+    static void writeLength(std::vector<byte_t>& output, std::size_t length)
+    {
+        for(; length >= 255; length -= 255)
+        {
+            output.push_back(255);
+        }
+
+        output.push_back(static_cast<byte_t>(length));
+    }
+
+    static void writeBlock(std::vector<byte_t>& output, std::span<const byte_t> literals, std::size_t matchLength, std::size_t offset)
+    {
+        std::size_t literalToken = std::min<std::size_t>(literals.size(), 15);
+        std::size_t matchToken = matchLength > 0 ? std::min<std::size_t>(matchLength - MIN_MATCH, 15) : 0;
+        output.push_back(static_cast<byte_t>(literalToken << 4 | matchToken));
+
+        if(literalToken == 15)
+        {
+            writeLength(output, literals.size() - 15);
+        }
+
+        output.insert(output.end(), literals.begin(), literals.end());
+
+        if(matchLength == 0)
+        {
+            return;
+        }
+
+        output.push_back(static_cast<byte_t>(offset & 0xFF));
+        output.push_back(static_cast<byte_t>(offset >> 8));
+
+        if(matchToken == 15)
+        {
+            writeLength(output, matchLength - MIN_MATCH - 15);
+        }
+    }
+
+    std::vector<byte_t> compressLZ(std::span<const byte_t> data)
+    {
+        std::vector<byte_t> output;
+        output.reserve(data.size() / 2 + 16);
+
+        // the last position each hash of four bytes was seen at
+        std::vector<std::size_t> lastSeen(std::size_t{1} << HASH_BITS, NO_POSITION);
+
+        std::size_t anchor = 0;
+        std::size_t position = 0;
+        while(position + MIN_MATCH <= data.size())
+        {
+            std::uint32_t value = read32(data.data() + position);
+            std::size_t& candidate = lastSeen[hash32(value)];
+            std::size_t matchStart = candidate;
+            candidate = position;
+
+            if(matchStart == NO_POSITION || position - matchStart > MAX_OFFSET || read32(data.data() + matchStart) != value)
+            {
+                position++;
+                continue;
+            }
+
+            std::size_t matchLength = MIN_MATCH;
+            while(position + matchLength < data.size() && data[matchStart + matchLength] == data[position + matchLength])
+            {
+                matchLength++;
+            }
+
+            writeBlock(output, data.subspan(anchor, position - anchor), matchLength, position - matchStart);
+
+            position += matchLength;
+            anchor = position;
+        }
+
+        writeBlock(output, data.subspan(anchor), 0, 0);
+
+        return output;
+    }
+
+    void decompressLZ(std::span<const byte_t> compressed, std::span<byte_t> destination)
+    {
+        std::size_t read = 0;
+        std::size_t written = 0;
+
+        auto readLength = [&](std::size_t length) {
+            byte_t extra;
+            do
+            {
+                if(read == compressed.size())
+                {
+                    throw DecompressionError();
+                }
+
+                extra = compressed[read++];
+                length += extra;
+            } while(extra == 255);
+
+            return length;
+        };
+
+        while(true)
+        {
+            if(read == compressed.size())
+            {
+                throw DecompressionError();
+            }
+
+            byte_t token = compressed[read++];
+
+            std::size_t literalCount = token >> 4;
+            if(literalCount == 15)
+            {
+                literalCount = readLength(literalCount);
+            }
+
+            if(literalCount > compressed.size() - read || literalCount > destination.size() - written)
+            {
+                throw DecompressionError();
+            }
+
+            std::memcpy(destination.data() + written, compressed.data() + read, literalCount);
+            read += literalCount;
+            written += literalCount;
+
+            // the last block has no match
+            if(read == compressed.size())
+            {
+                break;
+            }
+
+            if(compressed.size() - read < 2)
+            {
+                throw DecompressionError();
+            }
+
+            std::size_t offset = static_cast<std::size_t>(compressed[read]) | static_cast<std::size_t>(compressed[read + 1]) << 8;
+            read += 2;
+
+            std::size_t matchLength = (token & 0xFu) + MIN_MATCH;
+            if((token & 0xFu) == 15)
+            {
+                matchLength = readLength(matchLength);
+            }
+
+            if(offset == 0 || offset > written || matchLength > destination.size() - written)
+            {
+                throw DecompressionError();
+            }
+
+            byte_t* matchDestination = destination.data() + written;
+            const byte_t* matchSource = matchDestination - offset;
+            if(offset >= matchLength)
+            {
+                std::memcpy(matchDestination, matchSource, matchLength);
+            }
+            else
+            {
+                // an overlapping match repeats the bytes it has just written
+                for(std::size_t i = 0; i < matchLength; i++)
+                {
+                    matchDestination[i] = matchSource[i];
+                }
+            }
+
+            written += matchLength;
+        }
+
+        if(written != destination.size())
+        {
+            throw DecompressionError();
+        }
+    }
+
+    void DecompressionCache::trim()
+    {
+        while(m_size > m_capacity)
+        {
+            m_size -= m_entries.back().buffer->size();
+            m_index.erase(m_entries.back().key);
+            m_entries.pop_back();
+        }
+    }
+
+    std::shared_ptr<const std::vector<byte_t>> DecompressionCache::getOrDecompress(std::span<const byte_t> compressed, std::size_t uncompressedSize)
+    {
+        std::uint64_t evictionGeneration;
+        {
+            std::scoped_lock<std::mutex> lock{m_lock};
+
+            auto indexItr = m_index.find(compressed.data());
+            if(indexItr != m_index.end())
+            {
+                m_hits++;
+                m_entries.splice(m_entries.begin(), m_entries, indexItr->second);
+                return indexItr->second->buffer;
+            }
+
+            m_misses++;
+            evictionGeneration = m_evictionGeneration;
+        }
+
+        auto decompressed = std::make_shared<std::vector<byte_t>>(uncompressedSize);
+        decompressLZ(compressed, *decompressed);
+        Buffer buffer = std::move(decompressed);
+
+        // another thread may have decompressed the same file in the meantime
+        std::scoped_lock<std::mutex> lock{m_lock};
+
+        // a blob was evicted in the meantime, the address may be in it so it mustn't be cached
+        if(m_evictionGeneration != evictionGeneration)
+        {
+            return buffer;
+        }
+
+        auto indexItr = m_index.find(compressed.data());
+        if(indexItr != m_index.end())
+        {
+            m_entries.splice(m_entries.begin(), m_entries, indexItr->second);
+            return indexItr->second->buffer;
+        }
+
+        if(uncompressedSize <= m_capacity)
+        {
+            m_entries.push_front(CacheEntry{compressed.data(), buffer});
+            m_index.emplace(compressed.data(), m_entries.begin());
+            m_size += uncompressedSize;
+            trim();
+        }
+
+        return buffer;
+    }
+
+    void DecompressionCache::evict(std::span<const byte_t> blob)
+    {
+        auto blobStart = reinterpret_cast<std::uintptr_t>(blob.data());
+
+        std::scoped_lock<std::mutex> lock{m_lock};
+        m_evictionGeneration++;
+
+        for(auto entryItr = m_entries.begin(); entryItr != m_entries.end();)
+        {
+            if(reinterpret_cast<std::uintptr_t>(entryItr->key) - blobStart < blob.size())
+            {
+                m_size -= entryItr->buffer->size();
+                m_index.erase(entryItr->key);
+                entryItr = m_entries.erase(entryItr);
+            }
+            else
+            {
+                entryItr++;
+            }
+        }
+    }
+
+    void DecompressionCache::setCapacity(std::size_t capacity)
+    {
+        std::scoped_lock<std::mutex> lock{m_lock};
+        m_capacity = capacity;
+        trim();
+    }
+
+    DecompressionCacheStats DecompressionCache::getStats() const
+    {
+        std::scoped_lock<std::mutex> lock{m_lock};
+        return DecompressionCacheStats{m_capacity, m_size, m_hits, m_misses};
+    }
+
+    DecompressionCache::DecompressionCache(std::size_t capacity) :
+        m_capacity(capacity)
+    {
+    }
+}
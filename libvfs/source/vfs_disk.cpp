@@ -1,65 +1,504 @@
 #include "vfs_disk.hpp"
 
+#include <algorithm>
+#include <bit>
 #include <iostream>
 #include <fstream>
+#include <cstring>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 namespace vfs
 {
-    std::shared_ptr<Resource> DiskManager::getDiskResource(const std::string& fileName)
+    std::shared_ptr<Resource> DiskManager::getDiskResource(std::string_view fileName)
+    {
+        return getDiskResource(fileName, m_diskLoadMode);
+    }
+
+    std::shared_ptr<Resource> DiskManager::tryGetDiskResource(std::string_view fileName)
+    {
+        return tryGetDiskResource(fileName, m_diskLoadMode);
+    }
+
+    std::shared_ptr<Resource> DiskManager::getDiskResource(std::string_view fileName, DiskLoadMode loadMode)
+    {
+        auto file = tryGetDiskResource(fileName, loadMode);
+        if(!file)
+        {
+            throw FileDoesNotExistError(fileName);
+        }
+
+        return file;
+    }
+
+    std::shared_ptr<Resource> DiskManager::tryGetDiskResource(std::string_view fileName, DiskLoadMode loadMode)
+    {
+        auto diskFile = tryGetCachedDiskResource(fileName);
+        if(diskFile)
+        {
+            return diskFile;
+        }
+
+        // otherwise load from disk
+        std::string fileNameStr{fileName};
+
+        auto diskData = tryLoadDiskData(fileNameStr, getLoadOptions(loadMode));
+        if(!diskData)
+        {
+            return nullptr;
+        }
+
+        return cacheDiskResource(fileNameStr, std::make_shared<Resource>(std::move(*diskData), m_changeEpoch, m_writeQueue));
+    }
+
+    std::vector<std::shared_ptr<Resource>> DiskManager::tryGetDiskResources(std::span<const std::string_view> fileNames)
+    {
+        return tryGetDiskResources(fileNames, m_diskLoadMode);
+    }
+
+    std::vector<std::shared_ptr<Resource>> DiskManager::tryGetDiskResources(std::span<const std::string_view> fileNames, DiskLoadMode loadMode)
+    {
+        std::vector<std::shared_ptr<Resource>> files(fileNames.size());
+
+        // gather the files that need loading, each distinct name is only loaded once
+        std::vector<std::string> toLoad;
+        std::vector<std::size_t> toLoadIndices;
+        // keyed by the caller's views which outlive the call, so no string is built for names that are already loaded
+        std::unordered_map<std::string_view, std::size_t> firstIndices;
+        std::vector<std::pair<std::size_t, std::size_t>> duplicates;
+
+        for(std::size_t i = 0; i < fileNames.size(); i++)
+        {
+            auto[firstItr, inserted] = firstIndices.try_emplace(fileNames[i], i);
+            if(!inserted)
+            {
+                duplicates.emplace_back(i, firstItr->second);
+                continue;
+            }
+
+            files[i] = tryGetCachedDiskResource(fileNames[i]);
+            if(!files[i])
+            {
+                toLoad.emplace_back(fileNames[i]);
+                toLoadIndices.push_back(i);
+            }
+        }
+
+        auto loaded = tryLoadDiskDataBatch(toLoad, getLoadOptions(loadMode));
+
+        for(std::size_t i = 0; i < loaded.size(); i++)
+        {
+            if(!loaded[i])
+            {
+                continue;
+            }
+
+            auto file = std::make_shared<Resource>(std::move(*loaded[i]), m_changeEpoch, m_writeQueue);
+            files[toLoadIndices[i]] = cacheDiskResource(toLoad[i], std::move(file));
+        }
+
+        for(auto[index, firstIndex] : duplicates)
+        {
+            files[index] = files[firstIndex];
+        }
+
+        return files;
+    }
+
+    std::shared_ptr<Resource> DiskManager::tryGetCachedDiskResource(std::string_view fileName)
     {
+        DiskResourceShard& shard = getDiskResourceShard(fileName);
+
         // check for existing file
+        std::shared_ptr<Resource> diskFile;
+        const std::filesystem::path* diskFilePath = nullptr;
+        {
+            std::shared_lock<std::shared_mutex> lock{shard.lock};
+
+            auto loadedItr = shard.entries.find(fileName);
+            if(loadedItr != shard.entries.end()) 
+            {
+                diskFile = loadedItr->second.resource.lock();
+                diskFilePath = &loadedItr->second.path;
+            }
+        }
+
+        if(diskFile == nullptr)
+        {
+            return nullptr;
+        }
+
+        // entries are never erased and their path never changes so it can be used without the lock
+        if(!isResourceFresh(*diskFile, *diskFilePath))
+        {
+            // reloaded in place so everyone holding the file sees the change and its generation and the epoch are bumped
+            try
+            {
+                diskFile->reloadIfModified();
+            }
+            catch(const FileDoesNotExistError&)
+            {
+                return nullptr;
+            }
+        }
+
+        return diskFile;
+    }
+
+    std::shared_ptr<Resource> DiskManager::cacheDiskResource(const std::string& fileName, std::shared_ptr<Resource> file)
+    {
+        DiskResourceShard& shard = getDiskResourceShard(fileName);
+
+        DiskResourceEntry* entry;
         {
-            std::scoped_lock<std::mutex> lock{m_diskResourcesLock};
+            std::unique_lock<std::shared_mutex> lock{shard.lock};
 
-            if(m_diskResources.count(fileName) > 0) 
+            auto[entryItr, inserted] = shard.entries.try_emplace(fileName, fileName, file);
+            if(!inserted)
             {
-                auto diskFile = m_diskResources.at(fileName).lock();
-                if(diskFile != nullptr)
+                // another thread loaded the file too, everyone has to share the one that is tracked
+                auto cachedFile = entryItr->second.resource.lock();
+                if(cachedFile)
                 {
-                    // check for a more updated file
-                    auto lastModTime = diskFile->getLastModifiedTime(); 
-                    auto newModTime = tryGetLastModTime(fileName);
+                    return cachedFile;
+                }
 
-                    // if the new time is less than or the same as the old time
-                    if(!(lastModTime && newModTime && *newModTime > *lastModTime))
+                entryItr->second.resource = file;
+            }
+
+            entry = &entryItr->second;
+        }
+
+        if(m_reloadMode == ReloadMode::EVENT_LIVE_RELOAD && !entry->watched)
+        {
+            watchFile(fileName, *entry);
+        }
+
+        return file;
+    }
+
+    bool DiskManager::isResourceFresh(const Resource& resource, const std::filesystem::path& filePath) const
+    {
+        FreshnessPolicy policy = m_freshnessPolicy;
+
+        switch(policy)
+        {
+        case FreshnessPolicy::EXPLICIT_ONLY:
+            return true;
+        case FreshnessPolicy::TRUST_WATCHER:
+            if(m_reloadMode == ReloadMode::ASYNC_LIVE_RELOAD || m_reloadMode == ReloadMode::EVENT_LIVE_RELOAD)
+            {
+                return true;
+            }
+            break;
+        case FreshnessPolicy::TIME_TO_LIVE:
+            if(std::chrono::steady_clock::now() - resource.getLastCheckedTime() < std::chrono::milliseconds(m_freshnessTimeToLiveMs.load()))
+            {
+                return true;
+            }
+            break;
+        case FreshnessPolicy::ALWAYS_CHECK:
+            break;
+        }
+
+        // check for a more updated file
+        auto lastModTime = resource.getLastModifiedTime(); 
+        auto newModTime = tryGetLastModTime(filePath);
+
+        // if the new time is less than or the same as the old time
+        bool fresh = !(lastModTime && newModTime && *newModTime > *lastModTime);
+        if(fresh && policy == FreshnessPolicy::TIME_TO_LIVE)
+        {
+            resource.setLastCheckedTime(std::chrono::steady_clock::now());
+        }
+
+        return fresh;
+    }
+
+    // runs on the reload thread, where an exception would reach std::terminate, so a file that can't be read is skipped
+    static void reloadTrackedResource(Resource& file)
+    {
+        try
+        {
+            file.reloadIfModified();
+        }
+        catch(const std::exception&)
+        {
+            // the file was removed or couldn't be read between the stat and the load, it is picked up by a later change
+        }
+    }
+
+    DiskManager::DiskResourceShard& DiskManager::getDiskResourceShard(std::string_view fileName)
+    {
+        return m_diskResourceShards[StringHash{}(fileName) % DISK_RESOURCE_SHARD_COUNT];
+    }
+
+    void DiskManager::checkForUpdatedFiles(bool unwatchedOnly)
+    {
+        std::vector<std::shared_ptr<Resource>> trackedFiles;
+
+        if(unwatchedOnly)
+        {
+            // cleared first so a file that stops being watched during the scan re-raises it
+            m_hasUnwatchedFiles = false;
+        }
+
+        bool foundUnwatched = false;
+
+        for(auto& shard : m_diskResourceShards)
+        {
+            // take a snapshot of the live files so the stats and reloads happen without the shard lock
+            {
+                std::shared_lock<std::shared_mutex> lock{shard.lock};
+                for(auto& diskFile : shard.entries)
+                {
+                    if(unwatchedOnly && diskFile.second.watched)
                     {
-                        return diskFile;
+                        continue;
+                    }
+
+                    auto file = diskFile.second.resource.lock();
+                    if(file != nullptr)
+                    {
+                        trackedFiles.push_back(std::move(file));
                     }
                 }
             }
+
+            foundUnwatched = foundUnwatched || !trackedFiles.empty();
+
+            for(auto& file : trackedFiles)
+            {
+                reloadTrackedResource(*file);
+            }
+
+            trackedFiles.clear();
         }
 
-        // otherwise load from disk
-        auto file = std::make_shared<Resource>(fileName);
+        if(unwatchedOnly && foundUnwatched)
+        {
+            m_hasUnwatchedFiles = true;
+        }
+    }
 
+    void DiskManager::reloadTrackedFile(std::string_view fileName)
+    {
+        DiskResourceShard& shard = getDiskResourceShard(fileName);
+
+        std::shared_ptr<Resource> file;
         {
-            std::scoped_lock<std::mutex> lock{m_diskResourcesLock};
-            m_diskResources[fileName] = file;
+            std::shared_lock<std::shared_mutex> lock{shard.lock};
+
+            auto entryItr = shard.entries.find(fileName);
+            if(entryItr != shard.entries.end())
+            {
+                file = entryItr->second.resource.lock();
+            }
         }
 
-        return file;
+        if(file != nullptr)
+        {
+            reloadTrackedResource(*file);
+        }
     }
 
-    void DiskManager::checkForUpdatedFiles()
+    void DiskManager::unwatchTrackedFile(std::string_view fileName)
     {
-        m_diskResourcesLock.lock();
-        for(auto diskFile : m_diskResources)
+        DiskResourceShard& shard = getDiskResourceShard(fileName);
+        std::shared_lock<std::shared_mutex> lock{shard.lock};
+
+        auto entryItr = shard.entries.find(fileName);
+        if(entryItr != shard.entries.end())
+        {
+            entryItr->second.watched = false;
+            m_hasUnwatchedFiles = true;
+        }
+    }
+
+    void DiskManager::watchFile(const std::string& fileName, DiskResourceEntry& entry)
+    {
+#ifdef __linux__
         {
-            auto file = diskFile.second.lock();
-            if(file != nullptr)
+            std::scoped_lock<std::mutex> lock{m_watchesLock};
+
+            if(m_watchFd >= 0)
             {
-                auto lastModTime = file->getLastModifiedTime();
-                if(lastModTime) 
+                std::filesystem::path directory = entry.path.parent_path();
+                if(directory.empty())
                 {
-                    auto newModTime = tryGetLastModTime(diskFile.first);
-                    if(newModTime && *newModTime > *lastModTime) 
+                    directory = ".";
+                }
+
+                std::string directoryName = directory.string();
+
+                int watch = -1;
+                auto watchItr = m_directoryWatches.find(directoryName);
+                if(watchItr != m_directoryWatches.end())
+                {
+                    watch = watchItr->second;
+                }
+                else
+                {
+                    watch = inotify_add_watch(m_watchFd, directoryName.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_ATTRIB);
+                    if(watch >= 0)
+                    {
+                        m_directoryWatches.emplace(directoryName, watch);
+                    }
+                }
+
+                if(watch >= 0)
+                {
+                    auto& trackedNames = m_watchedDirectories[watch].files[entry.path.filename().string()];
+                    if(std::find(trackedNames.begin(), trackedNames.end(), fileName) == trackedNames.end())
                     {
-                        file->reload();
+                        trackedNames.push_back(fileName);
                     }
+
+                    entry.watched = true;
+                    return;
                 }
-            } 
-        }       
-        m_diskResourcesLock.unlock();
+            }
+        }
+#else
+        (void)fileName;
+#endif
+
+        // the file can't be watched so the reload thread falls back to polling it
+        entry.watched = false;
+        m_hasUnwatchedFiles = true;
+        wakeReloadThread();
+    }
+
+    void DiskManager::closeWatchDescriptors()
+    {
+#ifdef __linux__
+        if(m_watchFd >= 0)
+        {
+            ::close(m_watchFd);
+        }
+
+        if(m_wakeFd >= 0)
+        {
+            ::close(m_wakeFd);
+        }
+#endif
+
+        m_watchFd = -1;
+        m_wakeFd = -1;
+    }
+
+    void DiskManager::wakeReloadThread()
+    {
+#ifdef __linux__
+        if(m_wakeFd >= 0)
+        {
+            std::uint64_t wakeCount = 1;
+            [[maybe_unused]] auto written = ::write(m_wakeFd, &wakeCount, sizeof(wakeCount));
+        }
+#endif
+    }
+
+    void DiskManager::waitForWatchEvents(std::int64_t timeoutMs)
+    {
+#ifdef __linux__
+        if(m_watchFd >= 0)
+        {
+            std::array<pollfd, 2> pollFds{{{m_watchFd, POLLIN, 0}, {m_wakeFd, POLLIN, 0}}};
+            ::poll(pollFds.data(), pollFds.size(), static_cast<int>(timeoutMs));
+
+            // drain any wake ups so the next wait blocks again
+            std::uint64_t wakeCount;
+            [[maybe_unused]] auto readBytes = ::read(m_wakeFd, &wakeCount, sizeof(wakeCount));
+            return;
+        }
+#else
+        (void)timeoutMs;
+#endif
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(CHANGE_CHECK_DELAY_MS));
+    }
+
+    void DiskManager::processWatchEvents()
+    {
+#ifdef __linux__
+        std::vector<std::string> changedFiles;
+        std::vector<std::string> unwatchedFiles;
+        bool eventsLost = false;
+
+        alignas(inotify_event) std::array<char, 4096> buffer;
+
+        while(true)
+        {
+            auto length = ::read(m_watchFd, buffer.data(), buffer.size());
+            if(length <= 0)
+            {
+                break;
+            }
+
+            std::scoped_lock<std::mutex> lock{m_watchesLock};
+
+            for(std::size_t offset = 0; offset < static_cast<std::size_t>(length);)
+            {
+                inotify_event event;
+                std::memcpy(&event, buffer.data() + offset, sizeof(event));
+
+                auto directoryItr = m_watchedDirectories.find(event.wd);
+
+                if(event.mask & IN_Q_OVERFLOW)
+                {
+                    eventsLost = true;
+                }
+                else if(event.mask & IN_IGNORED)
+                {
+                    // the directory went away so its files can only be polled from now on
+                    if(directoryItr != m_watchedDirectories.end())
+                    {
+                        for(const auto& trackedNames : directoryItr->second.files)
+                        {
+                            unwatchedFiles.insert(unwatchedFiles.end(), trackedNames.second.begin(), trackedNames.second.end());
+                        }
+
+                        m_watchedDirectories.erase(directoryItr);
+                        std::erase_if(m_directoryWatches, [&event](const auto& watch){ return watch.second == event.wd; });
+                    }
+                }
+                else if(event.len > 0 && directoryItr != m_watchedDirectories.end())
+                {
+                    std::string_view name{buffer.data() + offset + sizeof(inotify_event)};
+
+                    auto namesItr = directoryItr->second.files.find(name);
+                    if(namesItr != directoryItr->second.files.end())
+                    {
+                        changedFiles.insert(changedFiles.end(), namesItr->second.begin(), namesItr->second.end());
+                    }
+                }
+
+                offset += sizeof(inotify_event) + event.len;
+            }
+        }
+
+        for(const auto& fileName : unwatchedFiles)
+        {
+            unwatchTrackedFile(fileName);
+        }
+
+        if(eventsLost)
+        {
+            checkForUpdatedFiles();
+            return;
+        }
+
+        for(const auto& fileName : changedFiles)
+        {
+            reloadTrackedFile(fileName);
+        }
+#endif
     }
 
     void DiskManager::enableAsyncReload()
@@ -85,15 +524,117 @@ namespace vfs
         m_changeCheckThread = std::nullopt;
     }
 
+    void DiskManager::enableEventReload()
+    {
+        if(m_changeCheckThread.has_value())
+        {
+            return;
+        }
+
+#ifdef __linux__
+        {
+            std::scoped_lock<std::mutex> lock{m_watchesLock};
+
+            m_watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+            // without a way to wake the thread every file is polled instead
+            if(m_watchFd < 0 || m_wakeFd < 0)
+            {
+                closeWatchDescriptors();
+            }
+        }
+#endif
+
+        // watch the files that were loaded before the mode was enabled
+        std::vector<std::pair<std::string, DiskResourceEntry*>> trackedFiles;
+        for(auto& shard : m_diskResourceShards)
+        {
+            std::shared_lock<std::shared_mutex> lock{shard.lock};
+            for(auto& diskFile : shard.entries)
+            {
+                trackedFiles.emplace_back(diskFile.first, &diskFile.second);
+            }
+        }
+
+        for(auto&[fileName, entry] : trackedFiles)
+        {
+            watchFile(fileName, *entry);
+        }
+
+        // 'this' is fine in this case because copying / moving of the class is disabled
+        m_changeCheckThread = std::jthread(
+            [this](std::stop_token stopToken)
+            {
+                std::stop_callback wakeOnStop{stopToken, [this]{ wakeReloadThread(); }};
+
+                auto lastPoll = std::chrono::steady_clock::now();
+
+                while(!stopToken.stop_requested()) {
+                    // only wake up periodically when there are files that have to be polled
+                    waitForWatchEvents(m_hasUnwatchedFiles ? CHANGE_CHECK_DELAY_MS : -1);
+
+                    if(stopToken.stop_requested())
+                    {
+                        break;
+                    }
+
+                    processWatchEvents();
+
+                    auto now = std::chrono::steady_clock::now();
+                    if(m_hasUnwatchedFiles && now - lastPoll >= std::chrono::milliseconds(CHANGE_CHECK_DELAY_MS))
+                    {
+                        checkForUpdatedFiles(true);
+                        lastPoll = now;
+                    }
+                }
+            }
+        );
+    }
+
+    void DiskManager::disableEventReload()
+    {
+        m_changeCheckThread = std::nullopt;
+
+        std::scoped_lock<std::mutex> lock{m_watchesLock};
+
+        closeWatchDescriptors();
+
+        m_watchedDirectories.clear();
+        m_directoryWatches.clear();
+        m_hasUnwatchedFiles = false;
+
+        for(auto& shard : m_diskResourceShards)
+        {
+            std::shared_lock<std::shared_mutex> shardLock{shard.lock};
+            for(auto& diskFile : shard.entries)
+            {
+                diskFile.second.watched = false;
+            }
+        }
+    }
+
     void DiskManager::setReloadMode(ReloadMode newMode)
     {
-        if(m_reloadMode == ReloadMode::ASYNC_LIVE_RELOAD && newMode != ReloadMode::ASYNC_LIVE_RELOAD) { 
+        ReloadMode oldMode = m_reloadMode;
+        if(oldMode == newMode)
+        {
+            return;
+        }
+
+        if(oldMode == ReloadMode::ASYNC_LIVE_RELOAD) { 
             disableAsyncReload();
-        } else if(m_reloadMode != ReloadMode::ASYNC_LIVE_RELOAD && newMode == ReloadMode::ASYNC_LIVE_RELOAD) { 
-            enableAsyncReload();
+        } else if(oldMode == ReloadMode::EVENT_LIVE_RELOAD) { 
+            disableEventReload();
         }
 
         m_reloadMode = newMode;
+
+        if(newMode == ReloadMode::ASYNC_LIVE_RELOAD) { 
+            enableAsyncReload();
+        } else if(newMode == ReloadMode::EVENT_LIVE_RELOAD) { 
+            enableEventReload();
+        }
     }
 
     ReloadMode DiskManager::getReloadMode() const
@@ -101,6 +642,41 @@ namespace vfs
         return m_reloadMode;
     }
 
+    void DiskManager::setFreshnessPolicy(FreshnessPolicy newPolicy)
+    {
+        m_freshnessPolicy = newPolicy;
+    }
+
+    FreshnessPolicy DiskManager::getFreshnessPolicy() const
+    {
+        return m_freshnessPolicy;
+    }
+
+    void DiskManager::setFreshnessTimeToLive(std::chrono::milliseconds timeToLive)
+    {
+        m_freshnessTimeToLiveMs = timeToLive.count();
+    }
+
+    void DiskManager::setDiskLoadMode(DiskLoadMode newMode)
+    {
+        m_diskLoadMode = newMode;
+    }
+
+    DiskLoadMode DiskManager::getDiskLoadMode() const
+    {
+        return m_diskLoadMode;
+    }
+
+    void DiskManager::setSequentialReadHint(bool enabled)
+    {
+        m_sequentialReadHint = enabled;
+    }
+
+    bool DiskManager::getSequentialReadHint() const
+    {
+        return m_sequentialReadHint;
+    }
+
     void DiskManager::pollForUpdatedFiles()
     {
         if(m_reloadMode == ReloadMode::POLL_LIVE_RELOAD)
@@ -109,21 +685,102 @@ namespace vfs
         }
     }
 
-    DiskManager::DiskManager(ReloadMode mode) : m_reloadMode(mode)
+    DiskLoadOptions DiskManager::getLoadOptions(DiskLoadMode loadMode) const
+    {
+        return DiskLoadOptions{loadMode, m_sequentialReadHint, m_loadMemoryResource.load()};
+    }
+
+    void DiskManager::setMemoryResource(std::shared_ptr<std::pmr::memory_resource> memoryResource)
+    {
+        std::scoped_lock<std::mutex> lock{m_memoryResourceLock};
+        m_memoryResource = std::move(memoryResource);
+        updateLoadMemoryResource();
+    }
+
+    std::shared_ptr<std::pmr::memory_resource> DiskManager::getMemoryResource() const
+    {
+        std::scoped_lock<std::mutex> lock{m_memoryResourceLock};
+        return m_memoryResource;
+    }
+
+    void DiskManager::setBufferAlignment(std::size_t alignment)
+    {
+        std::scoped_lock<std::mutex> lock{m_memoryResourceLock};
+        m_bufferAlignment = std::bit_ceil(std::max<std::size_t>(alignment, 1));
+        updateLoadMemoryResource();
+    }
+
+    std::size_t DiskManager::getBufferAlignment() const
+    {
+        std::scoped_lock<std::mutex> lock{m_memoryResourceLock};
+        return m_bufferAlignment;
+    }
+
+    void DiskManager::updateLoadMemoryResource()
+    {
+        if(m_bufferAlignment > 1)
+        {
+            m_loadMemoryResource = std::make_shared<AlignedMemoryResource>(m_bufferAlignment, m_memoryResource);
+        }
+        else
+        {
+            m_loadMemoryResource = m_memoryResource;
+        }
+    }
+
+    void DiskManager::setWriteBehind(bool enabled)
+    {
+        m_writeQueue->setEnabled(enabled);
+    }
+
+    bool DiskManager::getWriteBehind() const
+    {
+        return m_writeQueue->isEnabled();
+    }
+
+    void DiskManager::flushWrites()
+    {
+        m_writeQueue->flush();
+    }
+
+    std::uint64_t DiskManager::getChangeEpoch() const
+    {
+        return m_changeEpoch->load(std::memory_order_acquire);
+    }
+
+    DiskManager::DiskManager(ReloadMode mode, std::shared_ptr<ChangeCounter> changeEpoch) : 
+        m_reloadMode(mode),
+        m_changeEpoch(changeEpoch ? std::move(changeEpoch) : std::make_shared<ChangeCounter>(0)),
+        m_writeQueue(std::make_shared<WriteBehindQueue>())
     {
         if(mode == ReloadMode::ASYNC_LIVE_RELOAD)
         {
             enableAsyncReload();
         }
+        else if(mode == ReloadMode::EVENT_LIVE_RELOAD)
+        {
+            enableEventReload();
+        }
     }
 
     DiskManager::~DiskManager()
     {
-        for(auto& file : m_diskResources)
+        // queued writes still belong to files that are about to be disowned
+        m_writeQueue->stop();
+
+        if(m_reloadMode == ReloadMode::EVENT_LIVE_RELOAD)
         {
-            auto filePtr = file.second.lock();
-            if(filePtr != nullptr) {
-                filePtr->disown();
+            disableEventReload();
+        }
+
+        for(auto& shard : m_diskResourceShards)
+        {
+            for(auto& file : shard.entries)
+            {
+                auto filePtr = file.second.resource.lock();
+                if(filePtr != nullptr) {
+                    filePtr->disown();
+                }
             }
         }
     }
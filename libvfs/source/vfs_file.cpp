@@ -1,14 +1,50 @@
 #include "vfs_file.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 namespace vfs
 {
     ResourceAccessGuard File::read() const
     {
-        auto[lock, data] = m_resource->read();
+        auto buffer = m_resource->read();
+        if(buffer->isStreamed())
+        {
+            return readRange(0, buffer->size());
+        }
 
-        return ResourceAccessGuard(lock, data, m_resource);
+        return ResourceAccessGuard(std::move(buffer));
+    }
+
+    ResourceAccessGuard File::readRange(std::size_t offset, std::size_t length) const
+    {
+        auto buffer = m_resource->read();
+
+        offset = std::min(offset, buffer->size());
+        length = std::min(length, buffer->size() - offset);
+
+        if(!buffer->isStreamed())
+        {
+            auto data = buffer->data().subspan(offset, length);
+            return ResourceAccessGuard(std::move(buffer), data);
+        }
+
+        // the range is copied into its own buffer that the guard keeps alive
+        const auto& memoryResource = buffer->getMemoryResource();
+        ByteBuffer data(length, memoryResource ? memoryResource.get() : std::pmr::get_default_resource());
+        data.resize(buffer->readRange(offset, data));
+
+        return ResourceAccessGuard(std::make_shared<const ResourceBuffer>(std::move(data), buffer->getLastModifiedTime(), memoryResource));
+    }
+
+    FileReader File::openReader(std::size_t chunkSize, std::size_t readaheadChunks) const
+    {
+        return FileReader(m_resource->read(), chunkSize, readaheadChunks);
+    }
+
+    std::size_t File::getSize() const
+    {
+        return m_resource->read()->size();
     }
 
     void File::write(const std::span<const byte_t> data)
@@ -31,6 +67,11 @@ namespace vfs
         return m_resource->isDisowned();
     }
 
+    std::uint64_t File::getGeneration() const
+    {
+        return m_resource->getGeneration();
+    }
+
     void File::addObserver(std::shared_ptr<ResourceChangeObserver> observer)
     {
         m_resource->addObserver(observer);
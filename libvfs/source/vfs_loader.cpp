@@ -0,0 +1,117 @@
+#include "vfs_loader.hpp"
+
+#include <algorithm>
+
+namespace vfs
+{
+    void LoadWorkerPool::startWorkers()
+    {
+        m_workers.reserve(m_threadCount);
+        for(std::size_t i = 0; i < m_threadCount; i++)
+        {
+            m_workers.emplace_back([this](std::stop_token stopToken) {
+                runJobs(stopToken);
+            });
+        }
+    }
+
+    void LoadWorkerPool::stopWorkers()
+    {
+        std::vector<std::jthread> workers;
+        {
+            std::scoped_lock<std::mutex> lock{m_jobsLock};
+            workers.swap(m_workers);
+        }
+
+        for(auto& worker : workers)
+        {
+            worker.request_stop();
+        }
+
+        // joined as they go out of scope, outside the lock so running jobs can finish
+    }
+
+    void LoadWorkerPool::cancelJobs()
+    {
+        std::deque<LoadJob> jobs;
+        {
+            std::scoped_lock<std::mutex> lock{m_jobsLock};
+            jobs.swap(m_jobs);
+        }
+
+        // run outside the lock in case cancelling a job takes locks of its own
+        for(auto& job : jobs)
+        {
+            if(job.cancel)
+            {
+                job.cancel();
+            }
+        }
+    }
+
+    void LoadWorkerPool::runJobs(std::stop_token stopToken)
+    {
+        while(true)
+        {
+            LoadJob job;
+            {
+                std::unique_lock<std::mutex> lock{m_jobsLock};
+                if(!m_jobsAvailable.wait(lock, stopToken, [this]() { return !m_jobs.empty(); }))
+                {
+                    return;
+                }
+
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+
+            // jobs report their own errors, nothing is thrown back to the pool
+            job.run();
+        }
+    }
+
+    void LoadWorkerPool::submit(std::function<void()> job, std::function<void()> onCancelled)
+    {
+        {
+            std::scoped_lock<std::mutex> lock{m_jobsLock};
+            m_jobs.push_back(LoadJob{std::move(job), std::move(onCancelled)});
+
+            if(m_workers.empty())
+            {
+                startWorkers();
+            }
+        }
+
+        m_jobsAvailable.notify_one();
+    }
+
+    void LoadWorkerPool::setThreadCount(std::size_t threadCount)
+    {
+        stopWorkers();
+
+        std::scoped_lock<std::mutex> lock{m_jobsLock};
+        m_threadCount = std::max<std::size_t>(threadCount, 1);
+
+        if(!m_jobs.empty() && m_workers.empty())
+        {
+            startWorkers();
+        }
+    }
+
+    std::size_t LoadWorkerPool::getThreadCount()
+    {
+        std::scoped_lock<std::mutex> lock{m_jobsLock};
+        return m_threadCount;
+    }
+
+    LoadWorkerPool::LoadWorkerPool(std::size_t threadCount) : m_threadCount(std::max<std::size_t>(threadCount, 1))
+    {
+    }
+
+    LoadWorkerPool::~LoadWorkerPool()
+    {
+        // queued jobs are failed rather than dropped so nobody waits on them forever
+        cancelJobs();
+        stopWorkers();
+    }
+}
@@ -0,0 +1,139 @@
+#include "vfs_memory.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <utility>
+
+namespace vfs
+{
+    std::pmr::memory_resource* AlignedMemoryResource::getUpstreamResource() const
+    {
+        return m_upstream ? m_upstream.get() : std::pmr::get_default_resource();
+    }
+
+    void* AlignedMemoryResource::do_allocate(std::size_t bytes, std::size_t alignment)
+    {
+        return getUpstreamResource()->allocate(bytes, std::max(alignment, m_alignment));
+    }
+
+    void AlignedMemoryResource::do_deallocate(void* buffer, std::size_t bytes, std::size_t alignment)
+    {
+        getUpstreamResource()->deallocate(buffer, bytes, std::max(alignment, m_alignment));
+    }
+
+    bool AlignedMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+    {
+        auto otherAligned = dynamic_cast<const AlignedMemoryResource*>(&other);
+        return this == &other || (otherAligned != nullptr && otherAligned->m_alignment == m_alignment && 
+            getUpstreamResource()->is_equal(*otherAligned->getUpstreamResource()));
+    }
+
+    std::size_t AlignedMemoryResource::getAlignment() const
+    {
+        return m_alignment;
+    }
+
+    const std::shared_ptr<std::pmr::memory_resource>& AlignedMemoryResource::getUpstream() const
+    {
+        return m_upstream;
+    }
+
+    AlignedMemoryResource::AlignedMemoryResource(std::size_t alignment, std::shared_ptr<std::pmr::memory_resource> upstream) :
+        m_upstream(std::move(upstream)),
+        m_alignment(std::bit_ceil(std::max<std::size_t>(alignment, 1)))
+    {
+    }
+
+    BufferPool::SizeClassCounters& BufferPool::getCounters(std::size_t bytes)
+    {
+        if(bytes > m_largestPooledSize)
+        {
+            return m_unpooled;
+        }
+
+        // the class of the smallest power of two that fits the buffer
+        std::size_t blockSize = std::bit_ceil(std::max(bytes, SMALLEST_SIZE_CLASS));
+        return m_sizeClasses[static_cast<std::size_t>(std::countr_zero(blockSize) - std::countr_zero(SMALLEST_SIZE_CLASS))];
+    }
+
+    std::size_t BufferPool::getPooledSize(std::size_t bytes, std::size_t alignment) const
+    {
+        // some of the pool's block sizes aren't powers of two, so their blocks only have the fundamental alignment
+        if(alignment > alignof(std::max_align_t) && bytes <= m_largestPooledSize)
+        {
+            return std::bit_ceil(std::max(bytes, alignment));
+        }
+
+        return bytes;
+    }
+
+    void* BufferPool::do_allocate(std::size_t bytes, std::size_t alignment)
+    {
+        void* buffer = m_pool.allocate(getPooledSize(bytes, alignment), alignment);
+
+        SizeClassCounters& counters = getCounters(bytes);
+        counters.buffersInUse.fetch_add(1, std::memory_order_relaxed);
+        counters.bytesInUse.fetch_add(bytes, std::memory_order_relaxed);
+
+        m_totalAllocations.fetch_add(1, std::memory_order_relaxed);
+        std::size_t bytesInUse = m_bytesInUse.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+        std::size_t peakBytesInUse = m_peakBytesInUse.load(std::memory_order_relaxed);
+        while(peakBytesInUse < bytesInUse && !m_peakBytesInUse.compare_exchange_weak(peakBytesInUse, bytesInUse, std::memory_order_relaxed))
+        {
+        }
+
+        return buffer;
+    }
+
+    void BufferPool::do_deallocate(void* buffer, std::size_t bytes, std::size_t alignment)
+    {
+        m_pool.deallocate(buffer, getPooledSize(bytes, alignment), alignment);
+
+        SizeClassCounters& counters = getCounters(bytes);
+        counters.buffersInUse.fetch_sub(1, std::memory_order_relaxed);
+        counters.bytesInUse.fetch_sub(bytes, std::memory_order_relaxed);
+
+        m_bytesInUse.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+    bool BufferPool::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+    {
+        return this == &other;
+    }
+
+    BufferPoolStats BufferPool::getStats() const
+    {
+        BufferPoolStats stats;
+        stats.buffersInUse = m_unpooled.buffersInUse.load(std::memory_order_relaxed);
+        stats.bytesInUse = m_bytesInUse.load(std::memory_order_relaxed);
+        stats.peakBytesInUse = m_peakBytesInUse.load(std::memory_order_relaxed);
+        stats.totalAllocations = m_totalAllocations.load(std::memory_order_relaxed);
+        stats.unpooledBuffersInUse = m_unpooled.buffersInUse.load(std::memory_order_relaxed);
+        stats.unpooledBytesInUse = m_unpooled.bytesInUse.load(std::memory_order_relaxed);
+
+        stats.sizeClasses.reserve(m_sizeClassCount);
+        for(std::size_t i = 0; i < m_sizeClassCount; i++)
+        {
+            BufferPoolSizeClass sizeClass;
+            sizeClass.blockSize = SMALLEST_SIZE_CLASS << i;
+            sizeClass.buffersInUse = m_sizeClasses[i].buffersInUse.load(std::memory_order_relaxed);
+            sizeClass.bytesInUse = m_sizeClasses[i].bytesInUse.load(std::memory_order_relaxed);
+
+            stats.buffersInUse += sizeClass.buffersInUse;
+            stats.sizeClasses.push_back(sizeClass);
+        }
+
+        return stats;
+    }
+
+    BufferPool::BufferPool(std::size_t largestPooledSize, std::pmr::memory_resource* upstream) :
+        m_pool(std::pmr::pool_options{0, std::bit_ceil(std::max(largestPooledSize, SMALLEST_SIZE_CLASS))}, upstream),
+        m_largestPooledSize(std::bit_ceil(std::max(largestPooledSize, SMALLEST_SIZE_CLASS))),
+        m_sizeClasses(nullptr),
+        m_sizeClassCount(static_cast<std::size_t>(std::countr_zero(m_largestPooledSize) - std::countr_zero(SMALLEST_SIZE_CLASS)) + 1)
+    {
+        m_sizeClasses = std::make_unique<SizeClassCounters[]>(m_sizeClassCount);
+    }
+}
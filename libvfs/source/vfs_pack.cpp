@@ -0,0 +1,182 @@
+#include "vfs_pack.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "vfs_compression.hpp"
+
+namespace vfs
+{
+    // checks that [offset, offset + length) lies within size without overflowing
+    static bool isRangeWithin(std::uint64_t offset, std::uint64_t length, std::uint64_t size)
+    {
+        return offset <= size && length <= size - offset;
+    }
+
+    PackEntry PackFile::getEntry(std::size_t index) const
+    {
+        // the mapping is only byte aligned as far as the compiler knows, so entries are copied out
+        PackEntry entry;
+        std::memcpy(&entry, m_contents.data() + m_header.indexOffset + index * sizeof(PackEntry), sizeof(PackEntry));
+        return entry;
+    }
+
+    std::string_view PackFile::getEntryName(const PackEntry& entry) const
+    {
+        if(!isRangeWithin(entry.nameOffset, entry.nameLength, m_header.namesLength))
+        {
+            throw PackFormatError(m_filePath);
+        }
+
+        auto name = m_contents.subspan(m_header.namesOffset + entry.nameOffset, entry.nameLength);
+        return std::string_view(reinterpret_cast<const char*>(name.data()), name.size());
+    }
+
+    FileTableEntry PackFile::getEntryLocation(const PackEntry& entry) const
+    {
+        // an uncompressed file is as long as it is stored, a compressed one can't expand past what the codec allows
+        bool isStored = entry.compression == static_cast<std::uint32_t>(CompressionMethod::NONE) && entry.uncompressedSize == entry.length;
+        bool isCompressed = entry.compression == static_cast<std::uint32_t>(CompressionMethod::LZ) && 
+            entry.uncompressedSize <= getMaxLZDecompressedSize(entry.length);
+
+        bool isValid = isRangeWithin(entry.startByte, entry.length, m_header.dataLength) && (isStored || isCompressed);
+
+        if(!isValid)
+        {
+            throw PackFormatError(m_filePath);
+        }
+
+        return FileTableEntry{static_cast<std::size_t>(entry.startByte), static_cast<std::size_t>(entry.length), 
+            static_cast<CompressionMethod>(entry.compression), static_cast<std::size_t>(entry.uncompressedSize)};
+    }
+
+    std::size_t PackFile::getFileCount() const
+    {
+        return static_cast<std::size_t>(m_header.fileCount);
+    }
+
+    std::string_view PackFile::getFileName(std::size_t index) const
+    {
+        return getEntryName(getEntry(index));
+    }
+
+    FileTableEntry PackFile::getFileEntry(std::size_t index) const
+    {
+        return getEntryLocation(getEntry(index));
+    }
+
+    std::optional<FileTableEntry> PackFile::findFile(std::string_view fileName) const
+    {
+        // lower bound over the sorted index
+        std::size_t first = 0;
+        std::size_t count = getFileCount();
+        while(count > 0)
+        {
+            std::size_t step = count / 2;
+            if(getFileName(first + step) < fileName)
+            {
+                first += step + 1;
+                count -= step + 1;
+            }
+            else
+            {
+                count = step;
+            }
+        }
+
+        if(first == getFileCount())
+        {
+            return std::nullopt;
+        }
+
+        PackEntry entry = getEntry(first);
+        if(getEntryName(entry) != fileName)
+        {
+            return std::nullopt;
+        }
+
+        return getEntryLocation(entry);
+    }
+
+    void PackFile::validateIndex() const
+    {
+        for(std::size_t i = 0; i < getFileCount(); i++)
+        {
+            PackEntry entry = getEntry(i);
+            getEntryName(entry);
+            getEntryLocation(entry);
+        }
+    }
+
+    std::span<const byte_t> PackFile::getData() const
+    {
+        return m_contents.subspan(m_header.dataOffset, m_header.dataLength);
+    }
+
+    std::size_t PackFile::getAlignment() const
+    {
+        return static_cast<std::size_t>(m_header.alignment);
+    }
+
+    const std::string& PackFile::getFilePath() const
+    {
+        return m_filePath;
+    }
+
+    PackFile::PackFile(const std::string& filePath) :
+        m_header(),
+        m_filePath(filePath)
+    {
+        auto mappedData = tryMapDataFromDisk(filePath);
+        if(mappedData)
+        {
+            m_contents = mappedData->data();
+            m_storage = std::move(*mappedData);
+        }
+        else
+        {
+            auto loadedData = tryLoadDataFromDisk(filePath);
+            if(!loadedData)
+            {
+                throw FileDoesNotExistError(filePath);
+            }
+
+            // moving a vector keeps its heap buffer so the span stays valid
+            m_contents = *loadedData;
+            m_storage = std::move(*loadedData);
+        }
+
+        if(m_contents.size() < sizeof(PackHeader))
+        {
+            throw PackFormatError(filePath);
+        }
+
+        std::memcpy(&m_header, m_contents.data(), sizeof(PackHeader));
+
+        bool isValid = m_header.magic == PACK_MAGIC && m_header.version == PACK_VERSION &&
+            m_header.indexOffset <= m_contents.size() && m_header.fileCount <= (m_contents.size() - m_header.indexOffset) / sizeof(PackEntry) &&
+            isRangeWithin(m_header.namesOffset, m_header.namesLength, m_contents.size()) &&
+            isRangeWithin(m_header.dataOffset, m_header.dataLength, m_contents.size()) &&
+            std::has_single_bit(m_header.alignment);
+
+        if(!isValid)
+        {
+            throw PackFormatError(filePath);
+        }
+    }
+
+    Bundle openPack(const std::string& filePath)
+    {
+        auto pack = std::make_shared<const PackFile>(filePath);
+        auto data = pack->getData();
+
+        // a file read into memory on platforms without mapping may not be as aligned as the pack was written
+        auto dataAddress = reinterpret_cast<std::uintptr_t>(data.data());
+        std::size_t alignment = std::min(pack->getAlignment(), std::size_t{1} << std::countr_zero(dataAddress));
+
+        return Bundle{data, {}, alignment, {}, std::move(pack)};
+    }
+}
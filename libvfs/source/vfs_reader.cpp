@@ -0,0 +1,76 @@
+#include "vfs_reader.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace vfs
+{
+    void FileReader::prefetchAhead(std::size_t chunkEnd)
+    {
+        std::size_t windowEnd = std::min(size(), chunkEnd + m_chunkSize * m_readaheadChunks);
+        std::size_t windowStart = std::max(m_prefetchedTo, chunkEnd);
+
+        // only hint the part of the window that hasn't been hinted yet
+        if(windowStart < windowEnd)
+        {
+            m_buffer->prefetch(windowStart, windowEnd - windowStart);
+            m_prefetchedTo = windowEnd;
+        }
+    }
+
+    std::span<const byte_t> FileReader::next()
+    {
+        if(atEnd())
+        {
+            return {};
+        }
+
+        std::size_t length = std::min(m_chunkSize, size() - m_position);
+
+        if(!m_buffer->isStreamed())
+        {
+            auto chunk = m_buffer->data().subspan(m_position, length);
+            m_position += length;
+            return chunk;
+        }
+
+        // the following chunks are read in the background while this one is being used
+        prefetchAhead(m_position + length);
+
+        m_chunk.resize(length);
+        std::size_t bytesRead = m_buffer->readRange(m_position, m_chunk);
+
+        // a file truncated since it was opened ends early
+        m_position = bytesRead == length ? m_position + length : size();
+
+        return std::span<const byte_t>(m_chunk.data(), bytesRead);
+    }
+
+    void FileReader::seek(std::size_t offset)
+    {
+        m_position = std::min(offset, size());
+        m_prefetchedTo = m_position;
+    }
+
+    std::size_t FileReader::tell() const
+    {
+        return m_position;
+    }
+
+    std::size_t FileReader::size() const
+    {
+        return m_buffer->size();
+    }
+
+    bool FileReader::atEnd() const
+    {
+        return m_position >= size();
+    }
+
+    FileReader::FileReader(std::shared_ptr<const ResourceBuffer> buffer, std::size_t chunkSize, std::size_t readaheadChunks) :
+        m_buffer(std::move(buffer)),
+        m_chunkSize(std::max<std::size_t>(chunkSize, 1)),
+        m_readaheadChunks(readaheadChunks)
+    {
+    }
+}
@@ -1,14 +1,55 @@
 #include "vfs_resource.hpp"
+#include "vfs_writer.hpp"
 
 #include <fstream>
 #include <iostream>
 #include <chrono>
 #include <array>
+#include <algorithm>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define VFS_HAS_POSIX_IO
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace vfs
 {
-    std::optional<TimePoint> tryGetLastModTime(const std::string& filePath)
+    TimePoint toTimePoint(const std::timespec& modTime)
     {
+        auto sinceEpoch = std::chrono::sys_time<std::chrono::nanoseconds>(std::chrono::seconds(modTime.tv_sec) + std::chrono::nanoseconds(modTime.tv_nsec));
+
+        // system_clock may count in coarser units than file_clock, so the time doesn't go through it
+        return std::chrono::time_point_cast<TimePoint::duration>(std::chrono::file_clock::from_sys(sinceEpoch));
+    }
+
+#ifdef VFS_HAS_POSIX_IO
+    static TimePoint toTimePoint(const struct stat& fileStat)
+    {
+#ifdef __APPLE__
+        return toTimePoint(fileStat.st_mtimespec);
+#else
+        return toTimePoint(fileStat.st_mtim);
+#endif
+    }
+#endif
+
+    std::optional<TimePoint> tryGetLastModTime(const std::filesystem::path& filePath)
+    {
+#ifdef VFS_HAS_POSIX_IO
+        // stat is used so the time matches the one taken when the file was loaded
+        struct stat fileStat;
+        if(::stat(filePath.c_str(), &fileStat) != 0)
+        {
+            return std::nullopt;
+        }
+
+        return toTimePoint(fileStat);
+#else
         std::error_code timeGetError;
         auto lastModTime = std::filesystem::last_write_time(filePath, timeGetError);
 
@@ -18,21 +59,280 @@ namespace vfs
         }
 
         return lastModTime;
+#endif
+    }
+
+    [[noreturn]] static void throwLoadError(const std::string& filePath)
+    {
+        std::error_code existsError;
+        if(std::filesystem::exists(filePath, existsError))
+        {
+            throw FileSizeError(filePath);
+        }
+
+        throw FileDoesNotExistError(filePath);
     }
 
     std::vector<byte_t> loadDataFromDisk(const std::string& filePath)
     {
-        std::ifstream fileStream{filePath, std::ios::binary};
+        auto data = tryLoadDataFromDisk(filePath);
+        if(!data)
+        {
+            throwLoadError(filePath);
+        }
+
+        return std::move(*data);
+    }
+
+    static DiskData loadDiskData(const std::string& filePath)
+    {
+        auto diskData = tryLoadDiskData(filePath, DiskLoadOptions{});
+        if(!diskData)
+        {
+            throwLoadError(filePath);
+        }
+
+        return std::move(*diskData);
+    }
+
+    std::span<const byte_t> MappedData::data() const
+    {
+        return std::span<const byte_t>(static_cast<const byte_t*>(m_address), m_length);
+    }
+
+    MappedData& MappedData::operator=(MappedData&& other) noexcept
+    {
+        std::swap(m_address, other.m_address);
+        std::swap(m_length, other.m_length);
+        return *this;
+    }
+
+    MappedData::MappedData(MappedData&& other) noexcept
+    {
+        std::swap(m_address, other.m_address);
+        std::swap(m_length, other.m_length);
+    }
+
+    MappedData::MappedData(void* address, std::size_t length) : m_address(address), m_length(length)
+    {
+    }
+
+    MappedData::~MappedData()
+    {
+#ifdef VFS_HAS_POSIX_IO
+        if(m_address != nullptr)
+        {
+            ::munmap(m_address, m_length);
+        }
+#endif
+    }
+
+    StreamedData& StreamedData::operator=(StreamedData&& other) noexcept
+    {
+        std::swap(m_fd, other.m_fd);
+        std::swap(m_size, other.m_size);
+        std::swap(m_filePath, other.m_filePath);
+        return *this;
+    }
+
+    StreamedData::StreamedData(StreamedData&& other) noexcept
+    {
+        std::swap(m_fd, other.m_fd);
+        std::swap(m_size, other.m_size);
+        std::swap(m_filePath, other.m_filePath);
+    }
+
+    StreamedData::StreamedData(int fd, std::size_t size, std::string filePath) : 
+        m_fd(fd), 
+        m_size(size), 
+        m_filePath(std::move(filePath))
+    {
+    }
+
+    StreamedData::~StreamedData()
+    {
+#ifdef VFS_HAS_POSIX_IO
+        if(m_fd >= 0)
+        {
+            ::close(m_fd);
+        }
+#endif
+    }
+
+    std::size_t StreamedData::readAt(std::size_t offset, std::span<byte_t> destination) const
+    {
+        if(offset >= m_size)
+        {
+            return 0;
+        }
+
+        // reads stop at the size the file had when it was opened
+        destination = destination.first(std::min(destination.size(), m_size - offset));
+
+#ifdef VFS_HAS_POSIX_IO
+        std::size_t bytesCopied = 0;
+        while(bytesCopied < destination.size())
+        {
+            auto bytesRead = ::pread(m_fd, destination.data() + bytesCopied, destination.size() - bytesCopied, static_cast<off_t>(offset + bytesCopied));
+            if(bytesRead < 0)
+            {
+                if(errno == EINTR)
+                {
+                    continue;
+                }
+
+                throw FileReadError(m_filePath);
+            }
+
+            // the file was truncated since it was opened
+            if(bytesRead == 0)
+            {
+                break;
+            }
+
+            bytesCopied += static_cast<std::size_t>(bytesRead);
+        }
+
+        return bytesCopied;
+#else
+        std::ifstream fileStream{m_filePath, std::ios::binary};
         if(!fileStream)
         {
-            throw FileDoesNotExistError(filePath);
+            throw FileReadError(m_filePath);
         }
 
-        // create a new file
+        fileStream.seekg(static_cast<std::streamoff>(offset));
+        fileStream.read(reinterpret_cast<char*>(destination.data()), static_cast<std::streamsize>(destination.size()));
 
-        // read total contents of the file
-        std::vector<byte_t> data;
+        return static_cast<std::size_t>(fileStream.gcount());
+#endif
+    }
 
+    void StreamedData::prefetch(std::size_t offset, std::size_t length) const
+    {
+#ifdef POSIX_FADV_WILLNEED
+        if(m_fd >= 0 && length > 0)
+        {
+            ::posix_fadvise(m_fd, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+        }
+#else
+        (void)offset;
+        (void)length;
+#endif
+    }
+
+#ifdef VFS_HAS_POSIX_IO
+    /**
+     * @brief Closes a file descriptor when it goes out of scope
+     */
+    struct FileDescriptorGuard final
+    {
+        int fd;
+
+        ~FileDescriptorGuard()
+        {
+            if(fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+    };
+
+    static std::optional<MappedData> mapOpenFile(int fd, std::size_t length, const DiskLoadOptions& loadOptions)
+    {
+        // empty files can't be mapped
+        if(length == 0)
+        {
+            return MappedData();
+        }
+
+        void* address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(address == MAP_FAILED)
+        {
+            return std::nullopt;
+        }
+
+        if(loadOptions.sequentialHint)
+        {
+            ::madvise(address, length, MADV_SEQUENTIAL);
+        }
+
+        return MappedData(address, length);
+    }
+
+    static bool readOpenFile(int fd, std::size_t length, const DiskLoadOptions& loadOptions, auto& data)
+    {
+#ifdef POSIX_FADV_SEQUENTIAL
+        if(loadOptions.sequentialHint)
+        {
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+#else
+        (void)loadOptions;
+#endif
+
+        data.resize(length);
+
+        // read may return less than asked for so keep going until the whole file is in
+        std::size_t offset = 0;
+        while(offset < length)
+        {
+            auto bytesRead = ::pread(fd, data.data() + offset, length - offset, static_cast<off_t>(offset));
+            if(bytesRead < 0)
+            {
+                if(errno == EINTR)
+                {
+                    continue;
+                }
+
+                return false;
+            }
+
+            // the file was truncated since it was stat'ed
+            if(bytesRead == 0)
+            {
+                break;
+            }
+
+            offset += static_cast<std::size_t>(bytesRead);
+        }
+
+        data.resize(offset);
+        return true;
+    }
+
+    static bool writeOpenFile(int fd, std::span<const byte_t> data)
+    {
+        // write may write less than asked for so keep going until everything is out
+        std::size_t offset = 0;
+        while(offset < data.size())
+        {
+            auto bytesWritten = ::write(fd, data.data() + offset, data.size() - offset);
+            if(bytesWritten < 0)
+            {
+                if(errno == EINTR)
+                {
+                    continue;
+                }
+
+                return false;
+            }
+
+            offset += static_cast<std::size_t>(bytesWritten);
+        }
+
+        return true;
+    }
+#else
+    static bool readFileStream(const std::string& filePath, auto& data)
+    {
+        std::ifstream fileStream{filePath, std::ios::binary};
+        if(!fileStream)
+        {
+            return false;
+        }
+
+        // read total contents of the file
         // first read size of file
         fileStream.seekg(0, std::ios::end);
         std::streamoff fileSize = fileStream.tellg();
@@ -40,7 +340,7 @@ namespace vfs
 
         if(fileSize < 0)
         {
-            throw FileSizeError(filePath);
+            return false;
         }
 
         data.resize(
@@ -49,66 +349,323 @@ namespace vfs
         // then read the file in full
         fileStream.read(reinterpret_cast<char*>(data.data()), fileSize);
 
+        return true;
+    }
+#endif
+
+    std::optional<std::vector<byte_t>> tryLoadDataFromDisk(const std::string& filePath)
+    {
+        std::vector<byte_t> data;
+
+#ifdef VFS_HAS_POSIX_IO
+        FileDescriptorGuard file{::open(filePath.c_str(), O_RDONLY | O_CLOEXEC)};
+
+        struct stat fileStat;
+        if(file.fd < 0 || ::fstat(file.fd, &fileStat) != 0 || fileStat.st_size < 0)
+        {
+            return std::nullopt;
+        }
+
+        if(!readOpenFile(file.fd, static_cast<std::size_t>(fileStat.st_size), DiskLoadOptions{}, data))
+        {
+            return std::nullopt;
+        }
+#else
+        if(!readFileStream(filePath, data))
+        {
+            return std::nullopt;
+        }
+#endif
+
         return data;
     }
 
-    std::pair<std::unique_lock<std::mutex>, const std::span<const byte_t>> Resource::read() const
+    std::optional<MappedData> tryMapDataFromDisk(const std::string& filePath)
     {
-        if(m_disowned)
+#ifdef VFS_HAS_POSIX_IO
+        auto diskData = tryLoadDiskData(filePath, DiskLoadOptions{DiskLoadMode::MEMORY_MAP, false, nullptr});
+        if(!diskData)
         {
-            throw FileDisowned();
+            return std::nullopt;
         }
 
-        std::unique_lock<std::mutex> lock{m_dataLock};
+        return std::move(diskData->mappedData);
+#else
+        (void)filePath;
+        return std::nullopt;
+#endif
+    }
 
-        if(isFromDisk())
+    std::optional<TimePoint> writeDataToDisk(const std::string& filePath, std::span<const byte_t> data)
+    {
+#ifdef VFS_HAS_POSIX_IO
+        // the temporary file is in the same directory so the rename can't cross file systems
+        std::string tempPath = filePath + ".XXXXXX";
+        FileDescriptorGuard file{::mkostemp(tempPath.data(), O_CLOEXEC)};
+        if(file.fd < 0)
         {
-            const std::vector<byte_t>& ownedData = std::get<DiskData>(m_data).loadedData;
+            throw FileWriteError(filePath);
+        }
 
-            auto pair = std::make_pair(
-                std::unique_lock<std::mutex>(), 
-                std::span<const byte_t>(ownedData.begin(), ownedData.end()));
+        // keep the permissions of the file being replaced, the temporary file is only accessible by its owner
+        struct stat fileStat;
+        mode_t mode = ::stat(filePath.c_str(), &fileStat) == 0 ? (fileStat.st_mode & 07777) : 0644;
 
-            pair.first.swap(lock);
-            return pair;
+        // the modification time is taken from the temporary file, renaming it doesn't change it
+        bool written = ::fchmod(file.fd, mode) == 0 && writeOpenFile(file.fd, data) && ::fstat(file.fd, &fileStat) == 0;
+        if(!written || ::rename(tempPath.c_str(), filePath.c_str()) != 0)
+        {
+            ::unlink(tempPath.c_str());
+            throw FileWriteError(filePath);
         }
 
-        auto pair = std::make_pair(
-            std::unique_lock<std::mutex>(), 
-            std::get<DataReference>(m_data).data);
+        return toTimePoint(fileStat);
+#else
+        std::string tempPath = filePath + ".tmp";
+        {
+            std::ofstream fileStream{tempPath, std::ios::binary | std::ios::trunc};
+            fileStream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+            if(!fileStream)
+            {
+                std::error_code removeError;
+                std::filesystem::remove(tempPath, removeError);
+                throw FileWriteError(filePath);
+            }
+        }
 
-        pair.first.swap(lock);
+        std::error_code renameError;
+        std::filesystem::rename(tempPath, filePath, renameError);
+        if(renameError)
+        {
+            std::error_code removeError;
+            std::filesystem::remove(tempPath, removeError);
+            throw FileWriteError(filePath);
+        }
 
-        return pair;
+        return tryGetLastModTime(filePath);
+#endif
     }
 
-    void Resource::write(const std::span<const byte_t> data)
+    std::optional<DiskData> tryLoadDiskData(const std::string& filePath, const DiskLoadOptions& loadOptions)
     {
-        (void)data;
+        // the buffer gets its memory resource here as it isn't taken over when the buffer is moved into
+        DiskData diskData{filePath, ByteBuffer(loadOptions.getMemoryResource()), std::nullopt, loadOptions, {}, {}};
 
-        if(isFromDisk())
+#ifdef VFS_HAS_POSIX_IO
+        FileDescriptorGuard file{::open(filePath.c_str(), O_RDONLY | O_CLOEXEC)};
+        if(file.fd < 0)
+        {
+            return std::nullopt;
+        }
+
+        // one stat gives both the size and the modification time
+        struct stat fileStat;
+        if(::fstat(file.fd, &fileStat) != 0 || fileStat.st_size < 0)
+        {
+            return std::nullopt;
+        }
+
+        auto length = static_cast<std::size_t>(fileStat.st_size);
+        diskData.timeLastModified = toTimePoint(fileStat);
+
+        if(loadOptions.mode == DiskLoadMode::STREAM)
+        {
+#ifdef POSIX_FADV_SEQUENTIAL
+            if(loadOptions.sequentialHint)
+            {
+                ::posix_fadvise(file.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            }
+#endif
+            // the descriptor is kept open for the reads
+            diskData.streamedData = StreamedData(std::exchange(file.fd, -1), length, filePath);
+            return diskData;
+        }
+
+        if(loadOptions.mode == DiskLoadMode::MEMORY_MAP)
+        {
+            // the mapping stays valid after the descriptor is closed
+            auto mapping = mapOpenFile(file.fd, length, loadOptions);
+            if(!mapping)
+            {
+                return std::nullopt;
+            }
+
+            diskData.mappedData = std::move(*mapping);
+            return diskData;
+        }
+
+        bool loaded = readOpenFile(file.fd, length, loadOptions, diskData.loadedData);
+#else
+        diskData.timeLastModified = tryGetLastModTime(filePath);
+
+        if(loadOptions.mode == DiskLoadMode::STREAM)
+        {
+            std::error_code sizeError;
+            auto length = std::filesystem::file_size(filePath, sizeError);
+            if(sizeError)
+            {
+                return std::nullopt;
+            }
+
+            // without descriptors every read opens the file again
+            diskData.streamedData = StreamedData(-1, static_cast<std::size_t>(length), filePath);
+            return diskData;
+        }
+
+        diskData.loadOptions.mode = DiskLoadMode::COPY;
+
+        bool loaded = readFileStream(filePath, diskData.loadedData);
+#endif
+
+        if(!loaded)
         {
-            // write to file
-            throw std::logic_error("Feature not implemented!");
+            return std::nullopt;
+        }
+
+        return diskData;
+    }
+
+    ResourceBuffer::ResourceBuffer(DataReference reference) : 
+        m_storage(reference),
+        m_data(reference.data)
+    {
+    }
+
+    ResourceBuffer::ResourceBuffer(std::shared_ptr<const ResourceBuffer> contents, std::optional<TimePoint> timeLastModified) : 
+        m_memoryResource(contents->getMemoryResource()),
+        m_data(contents->data()),
+        m_timeLastModified(timeLastModified)
+    {
+        m_storage = DataReference{m_data, std::move(contents)};
+    }
+
+    ResourceBuffer::ResourceBuffer(DiskData&& diskData) : 
+        m_memoryResource(diskData.loadOptions.memoryResource),
+        m_timeLastModified(diskData.timeLastModified)
+    {
+        if(diskData.loadOptions.mode == DiskLoadMode::MEMORY_MAP)
+        {
+            m_data = diskData.mappedData.data();
+            m_storage = std::move(diskData.mappedData);
+        }
+        else if(diskData.loadOptions.mode == DiskLoadMode::STREAM)
+        {
+            // nothing is held in memory, m_data stays empty
+            m_storage = std::move(diskData.streamedData);
         }
         else
         {
-            throw std::runtime_error("Writing to non writeable resource!");
+            // moving a vector keeps its heap buffer so the span stays valid
+            m_data = std::span<const byte_t>(diskData.loadedData.begin(), diskData.loadedData.end());
+            m_storage = std::move(diskData.loadedData);
         }
     }
 
-    void Resource::reload()
+    ResourceBuffer::ResourceBuffer(ByteBuffer&& data, std::optional<TimePoint> timeLastModified, std::shared_ptr<std::pmr::memory_resource> memoryResource) : 
+        m_memoryResource(std::move(memoryResource)),
+        m_timeLastModified(timeLastModified)
     {
-        if(isFromDisk())
+        m_data = std::span<const byte_t>(data.begin(), data.end());
+        m_storage = std::move(data);
+    }
+
+    std::size_t ResourceBuffer::size() const
+    {
+        if(auto streamed = std::get_if<StreamedData>(&m_storage))
+        {
+            return streamed->size();
+        }
+
+        return m_data.size();
+    }
+
+    bool ResourceBuffer::isStreamed() const
+    {
+        return std::holds_alternative<StreamedData>(m_storage);
+    }
+
+    std::size_t ResourceBuffer::readRange(std::size_t offset, std::span<byte_t> destination) const
+    {
+        if(auto streamed = std::get_if<StreamedData>(&m_storage))
+        {
+            return streamed->readAt(offset, destination);
+        }
+
+        if(offset >= m_data.size())
+        {
+            return 0;
+        }
+
+        auto source = m_data.subspan(offset, std::min(destination.size(), m_data.size() - offset));
+        std::copy(source.begin(), source.end(), destination.begin());
+
+        return source.size();
+    }
+
+    void ResourceBuffer::prefetch(std::size_t offset, std::size_t length) const
+    {
+        if(auto streamed = std::get_if<StreamedData>(&m_storage))
         {
-            DiskData& dd = std::get<DiskData>(m_data);
+            streamed->prefetch(offset, length);
+        }
+    }
 
-            std::scoped_lock lock(m_dataLock);
-            
-            dd.timeLastModified = tryGetLastModTime(dd.dataSourceFileName);
-            dd.loadedData = loadDataFromDisk(dd.dataSourceFileName);
+    std::shared_ptr<const ResourceBuffer> Resource::read() const
+    {
+        if(m_disowned)
+        {
+            throw FileDisowned();
         }
-        
+
+        return m_buffer.load();
+    }
+
+    void Resource::publishWrite(std::span<const byte_t> data, std::optional<TimePoint> timeLastModified)
+    {
+        // mapped and streamed files use the file that was just written, unless it's still waiting to be written
+        if(timeLastModified && m_diskSource->loadOptions.mode != DiskLoadMode::COPY)
+        {
+            auto newData = tryLoadDiskData(m_diskSource->fileName, m_diskSource->loadOptions);
+            if(newData)
+            {
+                m_buffer.store(std::make_shared<const ResourceBuffer>(std::move(*newData)));
+                return;
+            }
+        }
+
+        const DiskLoadOptions& loadOptions = m_diskSource->loadOptions;
+        m_buffer.store(std::make_shared<const ResourceBuffer>(
+            ByteBuffer(data.begin(), data.end(), loadOptions.getMemoryResource()), timeLastModified, loadOptions.memoryResource));
+    }
+
+    void Resource::flushWrite()
+    {
+        std::scoped_lock lock(m_reloadLock);
+
+        // already written by a later write-through
+        if(!m_writePending.exchange(false))
+        {
+            return;
+        }
+
+        // the contents don't change so the generation stays the same, only the modification time is filled in
+        auto buffer = m_buffer.load();
+        auto timeLastModified = writeDataToDisk(m_diskSource->fileName, buffer->data());
+        if(m_diskSource->loadOptions.mode == DiskLoadMode::COPY)
+        {
+            // share the written contents rather than copying them just to attach the time
+            m_buffer.store(std::make_shared<const ResourceBuffer>(std::move(buffer), timeLastModified));
+        }
+        else
+        {
+            publishWrite(buffer->data(), timeLastModified);
+        }
+        setLastCheckedTime(std::chrono::steady_clock::now());
+    }
+
+    void Resource::notifyObservers()
+    {
         // copy a list of the observers
         m_observersLock.lock();
         auto observers = m_observers;
@@ -121,19 +678,145 @@ namespace vfs
             [](auto& ob){ ob->onFileReload(); });
     }
 
-    void Resource::disown()
+    void Resource::write(const std::span<const byte_t> data)
     {
-        m_disowned = true;
+        if(!isFromDisk())
+        {
+            throw std::runtime_error("Writing to non writeable resource!");
+        }
+
+        if(m_disowned)
+        {
+            throw FileDisowned();
+        }
+
+        bool queueWrite = false;
+        {
+            std::scoped_lock lock(m_reloadLock);
+
+            if(m_writeQueue && m_writeQueue->isEnabled())
+            {
+                // without a modification time freshness checks can't reload over the contents before they are flushed
+                publishWrite(data, std::nullopt);
+
+                // a resource that is already queued writes whatever its latest contents are when it is flushed
+                queueWrite = !m_writePending.exchange(true);
+            }
+            else
+            {
+                // the buffer gets the modification time of the written file so it isn't seen as changed on disk
+                publishWrite(data, writeDataToDisk(m_diskSource->fileName, data));
+                m_writePending = false;
+            }
+
+            m_generation.fetch_add(1, std::memory_order_release);
+            if(m_changeEpoch)
+            {
+                m_changeEpoch->fetch_add(1, std::memory_order_release);
+            }
+
+            setLastCheckedTime(std::chrono::steady_clock::now());
+        }
+
+        if(queueWrite)
+        {
+            m_writeQueue->queue(shared_from_this());
+        }
     }
 
-    std::optional<TimePoint> Resource::getLastModifiedTime() const
+    void Resource::replaceFromDisk()
+    {
+        auto newData = tryLoadDiskData(m_diskSource->fileName, m_diskSource->loadOptions);
+        if(!newData)
+        {
+            throw FileDoesNotExistError(m_diskSource->fileName);
+        }
+
+        // readers holding the old buffer keep it alive until they are done with it
+        m_buffer.store(std::make_shared<const ResourceBuffer>(std::move(*newData)));
+
+        // bumped after the store so anyone who sees the new generation also reads the new buffer
+        m_generation.fetch_add(1, std::memory_order_release);
+        if(m_changeEpoch)
+        {
+            m_changeEpoch->fetch_add(1, std::memory_order_release);
+        }
+
+        setLastCheckedTime(std::chrono::steady_clock::now());
+    }
+
+    void Resource::reload()
     {
         if(isFromDisk())
         {
-            return std::get<DiskData>(m_data).timeLastModified;
+            // only one reload at a time so an older load can't be published over a newer one
+            std::scoped_lock lock(m_reloadLock);
+
+            // the contents in memory are newer than the file until the write is flushed
+            if(m_writePending)
+            {
+                return;
+            }
+
+            replaceFromDisk();
         }
 
-        return std::nullopt;
+        notifyObservers();
+    }
+
+    bool Resource::reloadIfModified()
+    {
+        if(!isFromDisk())
+        {
+            return false;
+        }
+
+        {
+            // checked under the reload lock so a file that was just written through this resource isn't read back
+            std::scoped_lock lock(m_reloadLock);
+
+            auto lastModTime = m_buffer.load()->getLastModifiedTime();
+            if(m_writePending || !lastModTime)
+            {
+                return false;
+            }
+
+            auto newModTime = tryGetLastModTime(m_diskSource->fileName);
+            if(!newModTime || *newModTime <= *lastModTime)
+            {
+                return false;
+            }
+
+            replaceFromDisk();
+        }
+
+        notifyObservers();
+        return true;
+    }
+
+    void Resource::disown()
+    {
+        m_disowned = true;
+    }
+
+    std::optional<TimePoint> Resource::getLastModifiedTime() const
+    {
+        return m_buffer.load()->getLastModifiedTime();
+    }
+
+    std::uint64_t Resource::getGeneration() const
+    {
+        return m_generation.load(std::memory_order_acquire);
+    }
+
+    std::chrono::steady_clock::time_point Resource::getLastCheckedTime() const
+    {
+        return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(m_lastCheckedTicks.load()));
+    }
+
+    void Resource::setLastCheckedTime(std::chrono::steady_clock::time_point checkTime) const
+    {
+        m_lastCheckedTicks = checkTime.time_since_epoch().count();
     }
 
     bool Resource::isDisowned() const
@@ -143,12 +826,12 @@ namespace vfs
 
     bool Resource::isFromDisk() const
     {
-        return m_data.index() == 1;
+        return m_diskSource.has_value();
     }
 
     bool Resource::isDataReference() const
     {
-        return m_data.index() == 0;
+        return !m_diskSource.has_value();
     }
 
     void Resource::addObserver(std::shared_ptr<ResourceChangeObserver> observer)
@@ -163,17 +846,22 @@ namespace vfs
         m_observers.erase(std::find(m_observers.begin(), m_observers.end(), observer));
     }
 
-    Resource::Resource(const std::span<const byte_t> data) : m_data(DataReference{data})
+    Resource::Resource(const std::span<const byte_t> data, std::shared_ptr<const void> owner) : 
+        m_buffer(std::make_shared<const ResourceBuffer>(DataReference{data, std::move(owner)})),
+        m_lastCheckedTicks(std::chrono::steady_clock::now().time_since_epoch().count())
     {
     }
 
-    Resource::Resource(const std::string& fileName) : m_data(
-        DiskData{ 
-            fileName,
-            loadDataFromDisk(fileName),
-            tryGetLastModTime(fileName)
-        }
-    )
+    Resource::Resource(const std::string& fileName) : Resource(loadDiskData(fileName))
+    {
+    }
+
+    Resource::Resource(DiskData&& diskData, std::shared_ptr<ChangeCounter> changeEpoch, std::shared_ptr<WriteBehindQueue> writeQueue) : 
+        m_diskSource(DiskSource{diskData.dataSourceFileName, diskData.loadOptions}),
+        m_buffer(std::make_shared<const ResourceBuffer>(std::move(diskData))),
+        m_changeEpoch(std::move(changeEpoch)),
+        m_writeQueue(std::move(writeQueue)),
+        m_lastCheckedTicks(std::chrono::steady_clock::now().time_since_epoch().count())
     {
     }
 }
\ No newline at end of file
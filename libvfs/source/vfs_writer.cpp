@@ -0,0 +1,137 @@
+#include "vfs_writer.hpp"
+
+#include <chrono>
+
+namespace vfs
+{
+    void WriteBehindQueue::writeQueued(std::vector<std::shared_ptr<Resource>>& resources)
+    {
+        for(auto& resource : resources)
+        {
+            try
+            {
+                resource->flushWrite();
+            }
+            catch(...)
+            {
+                std::scoped_lock<std::mutex> lock{m_queueLock};
+                if(!m_writeError)
+                {
+                    m_writeError = std::current_exception();
+                }
+            }
+        }
+
+        {
+            std::scoped_lock<std::mutex> lock{m_queueLock};
+            m_flushing -= resources.size();
+        }
+
+        m_writesFlushed.notify_all();
+        resources.clear();
+    }
+
+    void WriteBehindQueue::runWrites(std::stop_token stopToken)
+    {
+        std::vector<std::shared_ptr<Resource>> resources;
+
+        while(true)
+        {
+            {
+                std::unique_lock<std::mutex> lock{m_queueLock};
+                if(!m_writesQueued.wait(lock, stopToken, [this]() { return !m_queued.empty(); }))
+                {
+                    return;
+                }
+
+                // keep collecting writes for a moment, a stop cuts it short
+                m_writesQueued.wait_for(lock, stopToken, std::chrono::milliseconds(WRITE_DELAY_MS), []() { return false; });
+
+                resources.swap(m_queued);
+                m_flushing += resources.size();
+            }
+
+            writeQueued(resources);
+        }
+    }
+
+    void WriteBehindQueue::queue(std::shared_ptr<Resource> resource)
+    {
+        {
+            std::scoped_lock<std::mutex> lock{m_queueLock};
+            m_queued.push_back(std::move(resource));
+
+            if(!m_writeThread)
+            {
+                m_writeThread.emplace([this](std::stop_token stopToken) {
+                    runWrites(stopToken);
+                });
+            }
+        }
+
+        m_writesQueued.notify_one();
+    }
+
+    void WriteBehindQueue::flush()
+    {
+        std::vector<std::shared_ptr<Resource>> resources;
+        {
+            std::scoped_lock<std::mutex> lock{m_queueLock};
+            resources.swap(m_queued);
+            m_flushing += resources.size();
+        }
+
+        // write what is queued on this thread rather than waiting for the delay
+        writeQueued(resources);
+
+        std::exception_ptr writeError;
+        {
+            std::unique_lock<std::mutex> lock{m_queueLock};
+            m_writesFlushed.wait(lock, [this]() { return m_flushing == 0; });
+
+            std::swap(writeError, m_writeError);
+        }
+
+        if(writeError)
+        {
+            std::rethrow_exception(writeError);
+        }
+    }
+
+    void WriteBehindQueue::setEnabled(bool enabled)
+    {
+        m_enabled = enabled;
+    }
+
+    bool WriteBehindQueue::isEnabled() const
+    {
+        return m_enabled;
+    }
+
+    void WriteBehindQueue::stop()
+    {
+        m_enabled = false;
+
+        // stop the thread first so the rest is written here, it is joined outside the lock so its last writes can finish
+        std::optional<std::jthread> writeThread;
+        {
+            std::scoped_lock<std::mutex> lock{m_queueLock};
+            writeThread.swap(m_writeThread);
+        }
+
+        writeThread.reset();
+
+        try
+        {
+            flush();
+        }
+        catch(...)
+        {
+        }
+    }
+
+    WriteBehindQueue::~WriteBehindQueue()
+    {
+        stop();
+    }
+}
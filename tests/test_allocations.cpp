@@ -0,0 +1,155 @@
+// Checks that looking up a file that is already loaded doesn't allocate
+
+#include <vfs.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string_view>
+
+static std::atomic<std::size_t> allocationCount = 0;
+
+static void* countedAllocate(std::size_t size, std::size_t alignment)
+{
+    allocationCount++;
+
+    void* memory = alignment > alignof(std::max_align_t) ?
+        std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment) : std::malloc(size == 0 ? 1 : size);
+    if(memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+void* operator new(std::size_t size)
+{
+    return countedAllocate(size, alignof(std::max_align_t));
+}
+
+void* operator new[](std::size_t size)
+{
+    return countedAllocate(size, alignof(std::max_align_t));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept
+{
+    std::free(memory);
+}
+
+static int failures = 0;
+
+// runs a lookup once to load the file and then again counting the allocations of the cache hit
+static void expectNoAllocations(std::string_view name, const auto& lookup)
+{
+    // files are only cached while someone holds them
+    std::size_t before = allocationCount;
+    auto loaded = lookup();
+
+    // loading the file creates its resource, if that isn't seen the counter isn't hooked up
+    if(allocationCount == before)
+    {
+        std::cout << "FAIL: " << name << " didn't count the allocations of the first load" << std::endl;
+        failures++;
+        return;
+    }
+
+    before = allocationCount;
+    lookup();
+    std::size_t allocations = allocationCount - before;
+
+    if(allocations != 0)
+    {
+        std::cout << "FAIL: " << name << " made " << allocations << " allocations" << std::endl;
+        failures++;
+    }
+    else
+    {
+        std::cout << "PASS: " << name << std::endl;
+    }
+}
+
+int main()
+{
+    static constexpr vfs::byte_t blob[] = {'b', 'u', 'n', 'd', 'l', 'e'};
+    static constexpr char names[] = "bundled.txt";
+    static constexpr vfs::FileIndexEntry index[] = {{0, 11, 0, 6}};
+
+    vfs::Bundle bundle{blob, {}, 1, {std::string_view(names, 11), index}};
+
+    const char* diskName = "allocations_test_file.txt";
+    {
+        std::ofstream diskFile{diskName, std::ios::binary};
+        diskFile << "disk";
+    }
+
+    {
+        vfs::VirtualFS fs;
+        fs.addGlobalBundle(bundle);
+        fs.addBundle("mounted", bundle);
+
+        // literals go straight through as string views, no std::string is built for the lookup
+        expectNoAllocations("getFile from a global bundle", [&]() { return fs.getFile("bundled.txt"); });
+        expectNoAllocations("getFileFromMountedBundle", [&]() { return fs.getFileFromMountedBundle("mounted", "bundled.txt"); });
+        expectNoAllocations("getFile from disk", [&]() { return fs.getFile(diskName); });
+        expectNoAllocations("getFileFromDisk", [&]() { return fs.getFileFromDisk(diskName); });
+
+        vfs::FileId bundleId = fs.intern("bundled.txt");
+        vfs::FileId diskId = fs.intern(diskName);
+        expectNoAllocations("getFile by id from a global bundle", [&]() { return fs.getFile(bundleId); });
+        expectNoAllocations("getFile by id from disk", [&]() { return fs.getFile(diskId); });
+    }
+
+    std::filesystem::remove(diskName);
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
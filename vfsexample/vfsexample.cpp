@@ -6,13 +6,15 @@
 int main()
 {
     vfs::VirtualFS fs;
-    fs.addGlobalBundle(gen::bundle);
+    fs.addGlobalBundle(gen::bundle());
 
     std::cout << "printing files in bundle: " << std::endl;
-    for(auto file : gen::bundle.files)
+    const vfs::FileIndex& index = gen::bundle().index;
+    for(std::size_t i = 0; i < index.getFileCount(); i++)
     {
-        auto filePtr = fs.getFile(std::string(file.first));
-        std::cout << file.first << std::endl;
+        std::string_view fileName = index.getFileName(i);
+        auto filePtr = fs.getFile(fileName);
+        std::cout << fileName << std::endl;
         auto handle = filePtr.read();
         for(vfs::byte_t b : handle.data())
         {
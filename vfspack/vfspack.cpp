@@ -2,10 +2,19 @@
 #include <fstream>
 #include <string>
 #include <filesystem>
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <sstream>
 #include <argparse_nowarn.hpp>
+#include <vfs_bundle_def.hpp>
+#include <vfs_compression.hpp>
+#include <vfs_pack_def.hpp>
+#include <vfs_resource.hpp>
 
-void writeSource(std::ostream& sourceWriter, const std::string& bundleName, const std::string& namespaceName, const std::vector<std::string>& files);
+void writeSource(std::ostream& sourceWriter, const std::string& bundleName, const std::string& namespaceName, std::vector<std::string> files, std::size_t alignment, bool compress, const std::optional<std::string>& blobPath);
 void writeHeader(std::ostream& headerWriter, const std::string& bundleName, const std::string& namespaceName);
+void writePack(std::ostream& packWriter, std::vector<std::string> files, std::size_t alignment, bool compress);
 
 std::vector<std::string> unpackPath(const std::string& path);
 
@@ -13,13 +22,7 @@ int main(int argc, char** argv)
 {
     argparse::ArgumentParser program("vfspack");
 
-    program.add_description("Program to take in a list of input files and collate them together into a C++ source file and header to be used with vfs");
-
-    program.add_argument("output_source")
-        .help("The path of the generated source file");
-
-    program.add_argument("output_header")
-        .help("The path of the generated header file");
+    program.add_description("Program to take in a list of input files and collate them together into a C++ source file and header, or a binary pack, to be used with vfs");
 
     program.add_argument("--bundle_name")
         .default_value(std::string("bundle"))
@@ -29,15 +32,34 @@ int main(int argc, char** argv)
         .default_value(std::string("gen"))
         .help("The namespace that will be used to enclose the bundle");
 
+    program.add_argument("--alignment")
+        .default_value(std::size_t{1})
+        .scan<'u', std::size_t>()
+        .help("The alignment in bytes of every file in the bundle, must be a power of two");
+
     program.add_argument("--recursive")
         .default_value(false)
         .implicit_value(true)
         .help("Recursively descends into directories and packs all files within them");
 
-    program.add_argument("input_files")
+    program.add_argument("--compress")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Compresses every file that gets smaller with the built in LZ codec, compressed files are decompressed when they are first loaded");
+
+    program.add_argument("--blob")
+        .help("Writes the file contents to a binary blob at this path which the generated source includes with the assembler's .incbin, "
+              "so they never pass through the C++ compiler. Needs GCC or Clang");
+
+    program.add_argument("--pack")
+        .help("Writes the files to a binary pack at this path that is opened at runtime with vfs::openPack instead of generating source");
+
+    // the output paths are only given when generating source, so they are split off by hand
+    program.add_argument("paths")
         .default_value(std::vector<std::string>{})
         .remaining()
-        .help("The files that will be packed into the generated source");
+        .help("output_source output_header input_files... The paths of the generated source and header followed by the files that will be packed into them, "
+              "with --pack only the files are given");
 
     try
     {
@@ -50,13 +72,34 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    std::ofstream sourceWriter{program.get<std::string>("output_source")};
-    std::ofstream headerWriter{program.get<std::string>("output_header")};
+    auto files = program.get<std::vector<std::string>>("paths");
+    auto packPath = program.present("--pack");
+
+    std::string outputSource;
+    std::string outputHeader;
+    if(!packPath)
+    {
+        if(files.size() < 2)
+        {
+            std::cout << "output_source and output_header are required unless --pack is given" << std::endl;
+            std::cout << program;
+            return 1;
+        }
 
-    auto files = program.get<std::vector<std::string>>("input_files");
+        outputSource = files.at(0);
+        outputHeader = files.at(1);
+        files.erase(files.begin(), files.begin() + 2);
+    }
     
     std::string bundleName = program.get<std::string>("--bundle_name");
     std::string namespaceName = program.get<std::string>("--namespace_name");
+
+    auto alignment = program.get<std::size_t>("--alignment");
+    if(alignment == 0 || (alignment & (alignment - 1)) != 0)
+    {
+        std::cout << "alignment must be a power of two" << std::endl;
+        return 1;
+    }
     
     if(program.get<bool>("--recursive"))
     {
@@ -70,8 +113,20 @@ int main(int argc, char** argv)
         files = newFiles;
     }
 
+    bool compress = program.get<bool>("--compress");
+
+    if(packPath)
+    {
+        std::ofstream packWriter{*packPath, std::ios::binary};
+        writePack(packWriter, files, alignment, compress);
+        return 0;
+    }
+
+    std::ofstream sourceWriter{outputSource};
+    std::ofstream headerWriter{outputHeader};
+
     writeHeader(headerWriter, bundleName, namespaceName);
-    writeSource(sourceWriter, bundleName, namespaceName, files);
+    writeSource(sourceWriter, bundleName, namespaceName, files, alignment, compress, program.present("--blob"));
 
     return 0;
 }
@@ -118,60 +173,342 @@ void writeHeader(std::ostream& headerWriter, const std::string& bundleName, cons
     headerWriter << "#pragma once\n";
     headerWriter << "#include <vfs_bundle_def.hpp>\n\n";
     headerWriter << "namespace " << namespaceName << "\n{\n";
-    headerWriter << "\textern vfs::Bundle " << bundleName << ";\n";
+    headerWriter << "\tconst vfs::Bundle& " << bundleName << "();\n";
     headerWriter << "}\n";
 }
 
-void writeSource(std::ostream& sourceWriter, const std::string& bundleName, const std::string& namespaceName, const std::vector<std::string>& files)
+static std::size_t alignUp(std::size_t offset, std::size_t alignment)
 {
-    std::vector<std::size_t> fileSizes;
-    fileSizes.reserve(files.size());
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+// where a file is stored within the blob or pack data region
+struct PackedFile
+{
+    std::string path;
+    std::size_t startByte = 0;
+    std::size_t length = 0; // the stored length
+    vfs::CompressionMethod compression = vfs::CompressionMethod::NONE;
+    std::size_t uncompressedSize = 0; // the length of the original file, the same as length unless it is compressed
+    std::vector<vfs::byte_t> compressedContents; // only kept for compressed files, others are streamed from disk as they are written
+};
+
+// lays the files out one after the other with each starting at the next multiple of the alignment
+static std::vector<PackedFile> layoutFiles(const std::vector<std::string>& files, std::size_t alignment, bool compress)
+{
+    std::vector<PackedFile> packedFiles;
+    packedFiles.reserve(files.size());
 
     std::size_t total = 0;
     for(const auto& path : files)
     {
-        std::size_t size = getFileSize(path);
-        total += size;
+        PackedFile packedFile;
+        packedFile.path = path;
+        packedFile.length = getFileSize(path);
+        packedFile.uncompressedSize = packedFile.length;
+
+        if(compress && packedFile.length > 0)
+        {
+            auto compressed = vfs::compressLZ(vfs::loadDataFromDisk(path));
+
+            // files that don't get smaller are stored as they are, so they are still read without a copy
+            if(compressed.size() < packedFile.length)
+            {
+                packedFile.compression = vfs::CompressionMethod::LZ;
+                packedFile.length = compressed.size();
+                packedFile.compressedContents = std::move(compressed);
+            }
+        }
 
-        fileSizes.push_back(size);
+        total = alignUp(total, alignment);
+        packedFile.startByte = total;
+        total += packedFile.length;
+
+        packedFiles.push_back(std::move(packedFile));
     }
 
+    return packedFiles;
+}
+
+static std::size_t getTotalSize(const std::vector<PackedFile>& packedFiles)
+{
+    return packedFiles.empty() ? 0 : packedFiles.back().startByte + packedFiles.back().length;
+}
+
+static void writeFileContents(std::ostream& writer, const PackedFile& packedFile)
+{
+    if(packedFile.compression != vfs::CompressionMethod::NONE)
+    {
+        writer.write(reinterpret_cast<const char*>(packedFile.compressedContents.data()), static_cast<std::streamsize>(packedFile.compressedContents.size()));
+        return;
+    }
+
+    std::ifstream file{packedFile.path, std::ios::binary};
+    if(packedFile.length > 0)
+    {
+        writer << file.rdbuf();
+    }
+}
+
+static void writeZeros(std::ostream& writer, std::size_t count)
+{
+    for(std::size_t i = 0; i < count; i++)
+    {
+        writer.put('\0');
+    }
+}
+
+static void writeBlob(std::ostream& blobWriter, const std::vector<PackedFile>& packedFiles)
+{
+    std::size_t written = 0;
+    for(const auto& packedFile : packedFiles)
+    {
+        // zero padding up to the start of the file
+        writeZeros(blobWriter, packedFile.startByte - written);
+
+        writeFileContents(blobWriter, packedFile);
+        written = packedFile.startByte + packedFile.length;
+    }
+
+    if(!blobWriter)
+    {
+        throw std::runtime_error("Could not write blob!");
+    }
+}
+
+// escapes a string for use within a string literal, applied twice for an assembler string within a C++ string
+static std::string escapeString(const std::string& str)
+{
+    std::string escaped;
+    for(char c : str)
+    {
+        if(c == '\\' || c == '"')
+        {
+            escaped += '\\';
+        }
+
+        escaped += c;
+    }
+
+    return escaped;
+}
+
+static void writeIncbinBlob(std::ostream& sourceWriter, const std::string& bundleName, const std::string& namespaceName, const std::string& blobPath, std::size_t alignment)
+{
+    // the assembler resolves the path relative to where it runs, so it is made absolute
+    std::string incbinPath = escapeString(escapeString(std::filesystem::absolute(blobPath).generic_string()));
+
+    std::string symbolName = namespaceName + "_" + bundleName + "_blob";
+    std::replace(symbolName.begin(), symbolName.end(), ':', '_');
+
+    // switch to a read only data section and back again afterwards
+    sourceWriter << "#if defined(_MSC_VER) && !defined(__clang__)\n";
+    sourceWriter << "#error \"Bundles written with vfspack --blob need an assembler that supports .incbin\"\n";
+    sourceWriter << "#elif defined(__APPLE__)\n";
+    sourceWriter << "#define " << symbolName << "_SECTION \".const_data\\n\"\n";
+    sourceWriter << "#define " << symbolName << "_SECTION_END \".text\\n\"\n";
+    sourceWriter << "#elif defined(_WIN32)\n";
+    sourceWriter << "#define " << symbolName << "_SECTION \".section .rdata,\\\"dr\\\"\\n\"\n";
+    sourceWriter << "#define " << symbolName << "_SECTION_END \".text\\n\"\n";
+    sourceWriter << "#else\n";
+    sourceWriter << "#define " << symbolName << "_SECTION \".pushsection .rodata\\n\"\n";
+    sourceWriter << "#define " << symbolName << "_SECTION_END \".popsection\\n\"\n";
+    sourceWriter << "#endif\n\n";
+
+    // the contents go straight from the blob into the object file without being parsed by the compiler
+    sourceWriter << "asm(" << symbolName << "_SECTION\n";
+    sourceWriter << "\t\".balign " << alignment << "\\n\"\n";
+    sourceWriter << "\t\"" << symbolName << ":\\n\"\n";
+    sourceWriter << "\t\".incbin \\\"" << incbinPath << "\\\"\\n\"\n";
+    sourceWriter << "\t" << symbolName << "_SECTION_END);\n\n";
+
+    // the asm label gives the array the symbol's exact name whatever prefix the platform adds to C names
+    sourceWriter << "namespace " << namespaceName << "\n{\n";
+    sourceWriter << "\textern \"C\" const vfs::byte_t " << bundleName << "_blob[] asm(\"" << symbolName << "\");\n";
+}
+
+// writes the file table as constexpr arrays, the files are already sorted by name so lookups can binary search it
+// returns whether the entries were written as vfs::CompactFileIndexEntry
+static bool writeIndex(std::ostream& sourceWriter, const std::string& bundleName, const std::vector<PackedFile>& packedFiles)
+{
+    // 32 bit entries are used when every file is uncompressed and ends within 4GiB of the blob start
+    bool compact = std::all_of(packedFiles.begin(), packedFiles.end(), [](const PackedFile& packedFile) {
+        return packedFile.compression == vfs::CompressionMethod::NONE && packedFile.startByte + packedFile.length <= std::numeric_limits<std::uint32_t>::max();
+    });
+
+    sourceWriter << "\tstatic constexpr char " << bundleName << "_names[] =\n";
+    sourceWriter << "\t\t\"\"";
+    for(const auto& packedFile : packedFiles)
+    {
+        sourceWriter << "\n\t\t\"" << escapeString(packedFile.path) << "\"";
+    }
+
+    sourceWriter << ";\n";
+
+    sourceWriter << "\tstatic constexpr std::array<vfs::" << (compact ? "CompactFileIndexEntry" : "FileIndexEntry") << ", " << packedFiles.size() << "> " << bundleName << "_index = {{";
+
+    std::size_t nameOffset = 0;
+    for(const auto& packedFile : packedFiles)
+    {
+        std::cout << "packing file: \"" << packedFile.path << "\"" << std::endl;
+
+        if(nameOffset + packedFile.path.size() > std::numeric_limits<std::uint32_t>::max())
+        {
+            throw std::runtime_error("File names are too long to be packed!");
+        }
+
+        sourceWriter << "\n\t\t{" << nameOffset << "," << packedFile.path.size() << "," << packedFile.startByte << "," << packedFile.length;
+        if(!compact)
+        {
+            sourceWriter << "," << packedFile.uncompressedSize << ",static_cast<vfs::CompressionMethod>(" << static_cast<std::uint32_t>(packedFile.compression) << ")";
+        }
+
+        sourceWriter << "},";
+        nameOffset += packedFile.path.size();
+    }
+
+    sourceWriter << "\n\t}};\n";
+    return compact;
+}
+
+// sorts the files by name for the index, a name given twice is only packed once so every lookup finds the same file
+static void sortUniqueFiles(std::vector<std::string>& files)
+{
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+}
+
+void writeSource(std::ostream& sourceWriter, const std::string& bundleName, const std::string& namespaceName, std::vector<std::string> files, std::size_t alignment, bool compress, const std::optional<std::string>& blobPath)
+{
+    sortUniqueFiles(files);
+
+    auto packedFiles = layoutFiles(files, alignment, compress);
+    std::size_t total = getTotalSize(packedFiles);
+
     // preamble
     sourceWriter << "#include <array>\n";
+    sourceWriter << "#include <span>\n";
+    sourceWriter << "#include <string_view>\n";
     sourceWriter << "#include <vfs_bundle_def.hpp>\n\n";
-    sourceWriter << "namespace " << namespaceName << "\n{\n";
-    sourceWriter << "\tstatic std::array<vfs::byte_t," << total << "> " << bundleName << "_blob = {";
 
-    //data
-    for(const auto& path : files)
+    if(blobPath)
+    {
+        std::ofstream blobWriter{*blobPath, std::ios::binary};
+        writeBlob(blobWriter, packedFiles);
+
+        writeIncbinBlob(sourceWriter, bundleName, namespaceName, *blobPath, alignment);
+    }
+    else
     {
-        std::ifstream file{path, std::ios::binary};
+        sourceWriter << "namespace " << namespaceName << "\n{\n";
+        sourceWriter << "\talignas(" << alignment << ") static constexpr std::array<vfs::byte_t," << total << "> " << bundleName << "_blob = {";
+
+        //data
+        std::size_t written = 0;
+        for(const auto& packedFile : packedFiles)
+        {
+            // zero padding up to the start of the file
+            for(; written < packedFile.startByte; written++)
+            {
+                sourceWriter << "0x0,";
+            }
+
+            std::ostringstream contents;
+            writeFileContents(contents, packedFile);
+
+            for(char c : contents.view())
+            {
+                sourceWriter << "0x" << std::hex << (static_cast<int>(c) & 0xFF) << ",";
+                written++;
+            }
+
+            sourceWriter << std::dec;
+        }
+
+        sourceWriter << std::dec;
+
+        // postamble
+        sourceWriter << "};\n";
+    }
+
+    bool compactIndex = writeIndex(sourceWriter, bundleName, packedFiles);
+
+    // only the Bundle itself needs constructing, it is built on first use so nothing runs before main
+    sourceWriter << "\tconst vfs::Bundle& " << bundleName << "()\n\t{\n";
+    sourceWriter << "\t\tstatic const vfs::Bundle instance{ std::span<const vfs::byte_t>(" << bundleName << (blobPath ? "_blob" : "_blob.data()") << ", " << total << "), {}, " << alignment << ", ";
+    sourceWriter << "{ std::string_view(" << bundleName << "_names, sizeof(" << bundleName << "_names) - 1), " << (compactIndex ? "{}, " : "") << bundleName << "_index } };\n";
+    sourceWriter << "\t\treturn instance;\n\t}\n";
+    sourceWriter << "}";
+}
 
-        char c;
-        while(file.get(c))
+template<typename T>
+static void writeStruct(std::ostream& writer, const T& value)
+{
+    writer.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void writePack(std::ostream& packWriter, std::vector<std::string> files, std::size_t alignment, bool compress)
+{
+    sortUniqueFiles(files);
+
+    auto packedFiles = layoutFiles(files, alignment, compress);
+
+    vfs::PackHeader header{};
+    header.magic = vfs::PACK_MAGIC;
+    header.version = vfs::PACK_VERSION;
+    header.fileCount = packedFiles.size();
+    header.alignment = alignment;
+    header.indexOffset = sizeof(vfs::PackHeader);
+
+    std::vector<vfs::PackEntry> entries;
+    entries.reserve(packedFiles.size());
+
+    std::size_t namesLength = 0;
+    for(const auto& packedFile : packedFiles)
+    {
+        if(namesLength + packedFile.path.size() > std::numeric_limits<std::uint32_t>::max())
         {
-            sourceWriter << "0x" << std::hex << (static_cast<int>(c) & 0xFF) << ",";
+            throw std::runtime_error("File names are too long to be packed!");
         }
+
+        entries.push_back(vfs::PackEntry{static_cast<std::uint32_t>(namesLength), static_cast<std::uint32_t>(packedFile.path.size()), 
+            packedFile.startByte, packedFile.length, packedFile.uncompressedSize, static_cast<std::uint32_t>(packedFile.compression), 0});
+
+        namesLength += packedFile.path.size();
     }
 
-    sourceWriter << std::dec;
+    header.namesOffset = header.indexOffset + entries.size() * sizeof(vfs::PackEntry);
+    header.namesLength = namesLength;
+    header.dataOffset = alignUp(header.namesOffset + header.namesLength, alignment);
+    header.dataLength = getTotalSize(packedFiles);
 
-    // postamble
-    sourceWriter << "};\n";
+    writeStruct(packWriter, header);
+    for(const auto& entry : entries)
+    {
+        writeStruct(packWriter, entry);
+    }
 
-    sourceWriter << "\tvfs::Bundle " << bundleName << "{ " << bundleName << "_blob, {";
-    
-    std::size_t lastFileEnd = 0;
+    for(const auto& packedFile : packedFiles)
+    {
+        packWriter << packedFile.path;
+    }
+
+    writeZeros(packWriter, header.dataOffset - (header.namesOffset + header.namesLength));
 
-    for(std::size_t i = 0; i < files.size(); i++)
+    std::size_t written = 0;
+    for(const auto& packedFile : packedFiles)
     {
-        std::cout << "packing file: \"" << files.at(i) << "\"" << std::endl;
+        std::cout << "packing file: \"" << packedFile.path << "\"" << std::endl;
 
-        auto size = fileSizes.at(i);
-        sourceWriter << "{\"" << files.at(i)  <<  "\", {" << lastFileEnd << "," << size << "}},";
-        lastFileEnd += size;
+        // zero padding up to the start of the file
+        writeZeros(packWriter, packedFile.startByte - written);
+
+        writeFileContents(packWriter, packedFile);
+        written = packedFile.startByte + packedFile.length;
     }
 
-    sourceWriter << "} };\n";
-    sourceWriter << "}";
+    if(!packWriter)
+    {
+        throw std::runtime_error("Could not write pack!");
+    }
 }